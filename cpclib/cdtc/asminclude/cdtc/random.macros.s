@@ -0,0 +1,68 @@
+;; Pseudo-random number generators of cdtc/random.h, as macros to inline in assembly code.
+;; It is intended to be used like this:
+;; .include "cdtc/random.macros.s"
+;; ...your code...
+;; ld hl,(my_state)
+;; CDTC_RANDOM_XORSHIFT16
+;; ld (my_state),hl
+
+;; a = next state of 8-bit Galois LFSR a, taps 0xB8, period 255, a must not be 0.
+;; Duration: 4 or 5 NOPs.
+.macro CDTC_RANDOM_LFSR8
+        srl     a               ; 2
+        jr      nc,.+4          ; 3/2
+        xor     #0xB8           ; 2
+.endm
+
+;; hl = next state of 16-bit Galois LFSR hl, taps 0xB400, period 65535, hl must not be 0.
+;; Only one new bit per step: take one bit per call, or call it 8 times per byte.
+;; Corrupts a.  Duration: 7 or 8 NOPs.
+.macro CDTC_RANDOM_LFSR16
+        srl     h               ; 2
+        rr      l               ; 2
+        jr      nc,.+6          ; 3/2
+        ld      a,h             ; 1
+        xor     #0xB4           ; 2
+        ld      h,a             ; 1
+.endm
+
+;; hl = next state of xorshift hl, shifts 7, 9, 8, period 65535, hl must not be 0.
+;; Corrupts a.  Duration: 14 NOPs.
+.macro CDTC_RANDOM_XORSHIFT16
+        ld      a,h             ; 1
+        rra                     ; 1
+        ld      a,l             ; 1
+        rra                     ; 1
+        xor     h               ; 1
+        ld      h,a             ; 1, x ^= x << 7 done on h, l still to do
+        ld      a,l             ; 1
+        rra                     ; 1
+        ld      a,h             ; 1
+        rra                     ; 1
+        xor     l               ; 1
+        ld      l,a             ; 1, x ^= x >> 9
+        xor     h               ; 1
+        ld      h,a             ; 1, x ^= x << 8
+.endm
+
+;; a = next byte of the additive lagged Fibonacci generator
+;; x[n] = x[n - 24] + x[n - 55] mod 256
+;; kept in page-aligned table _cdtc_random_table, index in _cdtc_random_table_index.
+;; Period at least 2^55 - 1.  See cdtc_random_table_seed.
+;; Corrupts de, hl.  Duration: 25 NOPs.
+.macro CDTC_RANDOM_TABLE8
+        ld      hl,#_cdtc_random_table_index ; 3
+        inc     (hl)            ; 3
+        ld      a,(hl)          ; 2, n
+        ld      h,#>_cdtc_random_table ; 2
+        ld      e,a             ; 1
+        sub     #24             ; 2
+        ld      l,a             ; 1
+        ld      d,(hl)          ; 2, x[n - 24]
+        sub     #55-24          ; 2
+        ld      l,a             ; 1
+        ld      a,(hl)          ; 2, x[n - 55]
+        add     a,d             ; 1
+        ld      l,e             ; 1
+        ld      (hl),a          ; 2, x[n]
+.endm
@@ -0,0 +1,85 @@
+#ifndef __CDTC_COROUTINE_H__
+#define __CDTC_COROUTINE_H__
+
+#include <stdint.h>
+
+/** Stackful cooperative coroutines.
+
+    Each coroutine runs a C function on its own stack, and gives the
+    CPU away with cdtc_coroutine_yield().  Code is then written as
+    plain loops instead of explicit state machines:
+
+    void enemy(void *arg)
+    {
+        while (alive(arg))
+        {
+            move(arg);
+            cdtc_coroutine_yield();
+        }
+    }
+
+    Stacks are fixed-size slots carved from a pool given to
+    cdtc_coroutine_init().  A slot is taken by cdtc_coroutine_create()
+    and given back when the coroutine function returns.
+
+    The program that called cdtc_coroutine_init() is a coroutine too,
+    called main below, that never ends.  All coroutines are in a ring
+    scheduled round-robin: cdtc_coroutine_yield() resumes the next
+    one, so a yield from main runs every other coroutine once until
+    they yield back.  A priority or event-driven policy can be built
+    on top of cdtc_coroutine_yield_to().
+
+    To run coroutines once per frame, main can wait for a counter
+    incremented at frame flyback (see cfwi_sched.h), then yield.
+    Never switch coroutines from an interrupt or event routine.
+
+    A switch saves IX and IY on the stack being left and swaps SP.
+    Other registers are caller-saved in the SDCC calling convention.
+    Cost, call and return included: cdtc_coroutine_yield 77 NOPs,
+    cdtc_coroutine_yield_to 61 NOPs.
+
+    Stack slot use: 4 bytes of control block, 4 bytes for the argument
+    and the return address of the coroutine function, 6 bytes while
+    suspended (return address, IX, IY), plus what the coroutine
+    function and its callees use, plus what an interrupt pushes
+    (firmware interrupts use a few tens of bytes of the interrupted
+    stack).  There is no overflow check.
+
+    The pool must lie in the central 32K of RAM (0x4000-0xBFFF): the
+    firmware enables the lower ROM during interrupts, and the stack is
+    read back then.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK: cpclib/cdtc/test/coroutine
+    has not been run on an emulator yet, its reference output is the
+    expected one, not a recorded run.
+*/
+
+/** Opaque coroutine control block, at the bottom of its stack slot. */
+typedef struct cdtc_coroutine_t cdtc_coroutine_t;
+
+typedef void (*cdtc_coroutine_entry_t)(void *arg);
+
+/** Coroutine currently running. */
+extern cdtc_coroutine_t *cdtc_coroutine_current;
+
+/** Number of coroutines created and not yet finished, main excluded. */
+extern uint8_t cdtc_coroutine_alive;
+
+/** Cut pool into pool_size / stack_size slots of stack_size bytes,
+    and make the caller the main coroutine.  stack_size must be at
+    least 16.  Forgets any previous coroutine. */
+void cdtc_coroutine_init(void *pool, uint16_t pool_size, uint16_t stack_size) __preserves_regs(iyh, iyl);
+
+/** Start entry(arg) in a new coroutine, that runs when the current
+    one next yields.  Returns NULL when all stack slots are taken. */
+cdtc_coroutine_t *cdtc_coroutine_create(cdtc_coroutine_entry_t entry, void *arg) __preserves_regs(iyh, iyl);
+
+/** Resume the next coroutine in the ring.  Returns when the ring
+    comes back to the caller. */
+void cdtc_coroutine_yield(void);
+
+/** Resume coroutine, which must be running (created and not
+    finished). */
+void cdtc_coroutine_yield_to(cdtc_coroutine_t *coroutine) __z88dk_fastcall;
+
+#endif /* __CDTC_COROUTINE_H__ */
@@ -0,0 +1,99 @@
+#ifndef __CDTC_DIV_H__
+#define __CDTC_DIV_H__
+
+#include <stdint.h>
+#include "cdtc/math.h"
+
+/** Fast division, modulo and decimal conversion.
+
+    SDCC divides with generic library routines, and printf("%u") or
+    sprintf pull in the whole formatted output code on top of them.
+    These routines are unrolled and return quotient and remainder at
+    once.
+
+    Cost in NOPs, call and return included:
+
+    function                          cost
+    cdtc_divmod_u16_u8__fastcall      180-200
+    cdtc_divmod_u16_u16__fastcall     280-360
+    cdtc_div10_u16__fastcall          about 85
+    cdtc_u16_to_decimal__fastcall     140-370
+    CDTC_DIV_U8_CONST                 about 100
+
+    plus packing arguments at call site.  Costs are counted from
+    instructions.  cpclib/cdtc/test/math_div checks results and
+    displays timings against SDCC's when run.
+
+    Division by zero does not fail: the quotient is all ones and the
+    remainder is x, or its low byte for cdtc_divmod_u16_u8.
+
+    Arguments are packed in one fastcall parameter, see the macros
+    below which do it for you.  Quotient is in the low 16 bits of the
+    result, remainder in the high 16 bits.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK: cpclib/cdtc/test/math_div
+    has not been run on an emulator yet, its reference output is the
+    expected one, not a recorded run.  The algorithms of
+    cdtc_div10_u16__fastcall and CDTC_DIV_U8_CONST are checked on the
+    host against every input.
+*/
+
+/** y in bits 16-23, x in bits 0-15.  Restoring division, unrolled. */
+uint32_t cdtc_divmod_u16_u8__fastcall(uint32_t y_x) __z88dk_fastcall __preserves_regs(b, iyh, iyl);
+
+/** x in bits 16-31, y in bits 0-15.  Restoring division, unrolled. */
+uint32_t cdtc_divmod_u16_u16__fastcall(uint32_t x_y) __z88dk_fastcall __preserves_regs(b, iyh, iyl);
+
+/** Division by 10 by multiply-shift, with shifts and adds instead of
+    a multiplication. */
+uint32_t cdtc_div10_u16__fastcall(uint16_t x) __z88dk_fastcall __preserves_regs(b, iyh, iyl);
+
+#define CDTC_DIVMOD_U16_U8(x, y) cdtc_divmod_u16_u8__fastcall(((uint32_t)(uint8_t)(y) << 16) | (uint16_t)(x))
+#define CDTC_DIV_U16_U8(x, y) ((uint16_t)CDTC_DIVMOD_U16_U8((x), (y)))
+#define CDTC_MOD_U16_U8(x, y) ((uint8_t)(CDTC_DIVMOD_U16_U8((x), (y)) >> 16))
+
+#define CDTC_DIVMOD_U16_U16(x, y) cdtc_divmod_u16_u16__fastcall(((uint32_t)(uint16_t)(x) << 16) | (uint16_t)(y))
+#define CDTC_DIV_U16_U16(x, y) ((uint16_t)CDTC_DIVMOD_U16_U16((x), (y)))
+#define CDTC_MOD_U16_U16(x, y) ((uint16_t)(CDTC_DIVMOD_U16_U16((x), (y)) >> 16))
+
+#define CDTC_DIV10_U16(x) ((uint16_t)cdtc_div10_u16__fastcall((x)))
+#define CDTC_MOD10_U16(x) ((uint8_t)(cdtc_div10_u16__fastcall((x)) >> 16))
+
+/** Division of a byte by a constant d from 1 to 255, by multiply-shift:
+
+    x / d = (x * m) >> (8 + k)
+
+    with k = ceil(log2(d)) and m = ceil(2^(8 + k) / d), exact for all
+    8-bit x.  m takes 9 bits, so the product is x * (m - 256) plus x
+    added back without overflow.  The product uses the quarter square
+    table of cdtc/math.h.  d must be a constant for the compiler to
+    compute m and k.  Static inline needs C99 or later, SDCC's default:
+    with --std-sdcc89 or --std-c89 these macros are left out. */
+#define CDTC_DIV_CEIL_LOG2_U8(d)                                        \
+        ((d) <= 1 ? 0 : (d) <= 2 ? 1 : (d) <= 4 ? 2 : (d) <= 8 ? 3      \
+         : (d) <= 16 ? 4 : (d) <= 32 ? 5 : (d) <= 64 ? 6 : (d) <= 128 ? 7 : 8)
+#define CDTC_DIV_MAGIC_U8(d) ((uint8_t)(((1UL << (8 + CDTC_DIV_CEIL_LOG2_U8(d))) + (d) - 1) / (d)))
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+static inline uint8_t cdtc_div_u8_magic(uint8_t x, uint8_t magic, uint8_t shift)
+{
+        uint8_t hi = CDTC_MUL_U8_U8(x, magic) >> 8;
+
+        return (uint8_t)((((uint8_t)(x - hi) >> 1) + hi) >> (shift - 1));
+}
+
+#define CDTC_DIV_U8_CONST(x, d)                                         \
+        ((d) == 1 ? (uint8_t)(x)                                        \
+         : cdtc_div_u8_magic((x), CDTC_DIV_MAGIC_U8(d), CDTC_DIV_CEIL_LOG2_U8(d)))
+#define CDTC_MOD_U8_CONST(x, d) ((uint8_t)((x) - CDTC_DIV_U8_CONST((x), (d)) * (d)))
+#endif
+
+/** Write x as 5 decimal digits with leading zeros and a terminating
+    0 in a buffer of at least 6 bytes, by subtracting powers of ten.
+    Returns a pointer into the buffer to the first digit that is not a
+    leading zero, so that 0 gives "0". */
+char *cdtc_u16_to_decimal__fastcall(uint32_t buffer_x) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+#define CDTC_U16_TO_DECIMAL(buffer, x) cdtc_u16_to_decimal__fastcall(((uint32_t)(uint16_t)(buffer) << 16) | (uint16_t)(x))
+
+#endif /* __CDTC_DIV_H__ */
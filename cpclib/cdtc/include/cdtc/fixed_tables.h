@@ -0,0 +1,146 @@
+#ifndef __CDTC_FIXED_TABLES_H__
+#define __CDTC_FIXED_TABLES_H__
+
+#include <stdint.h>
+
+/** Fixed-point sin, cos, atan2, reciprocal and square root by table
+    lookup.
+
+    Tables are generated at build time by tool/cdtc_tablegen, only
+    those listed in cdtc_project.conf, for example:
+
+    CDTC_TABLES=sin atan
+    CDTC_TABLES_SIN_SIZE=128
+
+    The project Makefile passes the sizes to the compiler as the
+    CDTC_TABLES_*_SIZE macros below, so that they always match the
+    generated tables.  Using a table that is not listed fails at link
+    time.
+
+    Each table starts on a 256-byte boundary in linker area
+    _CDTC_ALIGNED, like the tables of cdtc/math.h, see there about
+    CDTC_ALIGNED_LOC.  16-bit values are split in a page of low bytes
+    and a page of high bytes, so a lookup is two byte reads at the
+    same index, without any 16-bit index arithmetic.
+
+    Angles are in units of a full turn divided by
+    CDTC_TABLES_SIN_SIZE, so that with the default size of 256 a
+    uint8_t angle wraps around by itself.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK: cpclib/cdtc/test/fixed_tables
+    has not been run on an emulator yet, its reference output is the
+    expected one, not a recorded run.  The generated tables and
+    cdtc_atan2 are checked on the host.
+*/
+
+/** Angles per full turn: 64, 128 or 256. */
+#ifndef CDTC_TABLES_SIN_SIZE
+#define CDTC_TABLES_SIN_SIZE 256
+#endif
+
+/** Ratio steps of the atan octant table, a power of two up to 128. */
+#ifndef CDTC_TABLES_ATAN_SIZE
+#define CDTC_TABLES_ATAN_SIZE 128
+#endif
+
+/** Entries of the reciprocal table, up to 256. */
+#ifndef CDTC_TABLES_RECIP_SIZE
+#define CDTC_TABLES_RECIP_SIZE 256
+#endif
+
+/** Entries of the square root table, up to 256. */
+#ifndef CDTC_TABLES_SQRT_SIZE
+#define CDTC_TABLES_SQRT_SIZE 256
+#endif
+
+/** Signed 8.8, round(256 * sin(2 * pi * a / CDTC_TABLES_SIN_SIZE)). */
+extern const uint8_t cdtc_sin_low[CDTC_TABLES_SIN_SIZE];
+extern const uint8_t cdtc_sin_high[CDTC_TABLES_SIN_SIZE];
+
+/** round(atan(i / CDTC_TABLES_ATAN_SIZE)) in angle units, i from 0
+    to CDTC_TABLES_ATAN_SIZE included. */
+extern const uint8_t cdtc_atan_octant[CDTC_TABLES_ATAN_SIZE + 1];
+
+/** Unsigned 0.16, round(65536 / i), 0xFFFF for 0 and 1. */
+extern const uint8_t cdtc_recip_low[CDTC_TABLES_RECIP_SIZE];
+extern const uint8_t cdtc_recip_high[CDTC_TABLES_RECIP_SIZE];
+
+/** Unsigned 8.8, round(256 * sqrt(i)). */
+extern const uint8_t cdtc_sqrt_low[CDTC_TABLES_SQRT_SIZE];
+extern const uint8_t cdtc_sqrt_high[CDTC_TABLES_SQRT_SIZE];
+
+/** True if the tables are placed correctly, checking the first one
+    of the project is enough. */
+#define CDTC_FIXED_TABLE_ALIGNED(table) (((uint16_t)(table) & 0xFF) == 0)
+
+/** Angle a modulo a full turn. */
+#define CDTC_ANGLE(a) ((uint8_t)(a) & (CDTC_TABLES_SIN_SIZE - 1))
+
+/** Accessors, returning 8.8 or 0.16 values.  Arguments are evaluated
+    twice. */
+#define CDTC_TABLE_16(table, i) (((uint16_t)table##_high[(i)] << 8) | table##_low[(i)])
+
+#define CDTC_SIN(a) ((int16_t)CDTC_TABLE_16(cdtc_sin, CDTC_ANGLE(a)))
+#define CDTC_COS(a) ((int16_t)CDTC_TABLE_16(cdtc_sin, CDTC_ANGLE((a) + CDTC_TABLES_SIN_SIZE / 4)))
+#define CDTC_ATAN_OCTANT(i) (cdtc_atan_octant[(i)])
+#define CDTC_RECIP(i) CDTC_TABLE_16(cdtc_recip, (i))
+#define CDTC_SQRT(i) CDTC_TABLE_16(cdtc_sqrt, (i))
+
+/** Angle of vector (x, y) in angle units, 0 along positive x, a
+    quarter turn along positive y.  Needs the atan table.
+
+    Both coordinates are scaled down to 8 bits, then the ratio of the
+    smaller to the larger picks an entry of the octant table, and
+    symmetries give the other octants.  Error is within one angle unit
+    plus the octant table resolution.  Costs one 16-bit division,
+    about 1000 NOPs with SDCC's __divuint.  atan2(0, 0) is 0.
+
+    Static inline needs C99 or later, SDCC's default: with
+    --std-sdcc89 or --std-c89 this function is left out.
+*/
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+static inline uint8_t cdtc_atan2(int16_t y, int16_t x)
+{
+        uint16_t ax = x < 0 ? -(uint16_t)x : (uint16_t)x;
+        uint16_t ay = y < 0 ? -(uint16_t)y : (uint16_t)y;
+        uint16_t small = ax;
+        uint16_t big = ay;
+        uint8_t angle;
+
+        if (ay <= ax)
+        {
+                small = ay;
+                big = ax;
+        }
+
+        if (big == 0)
+        {
+                return 0;
+        }
+
+        while (big >= 256)
+        {
+                big >>= 1;
+                small >>= 1;
+        }
+
+        angle = cdtc_atan_octant[(small * CDTC_TABLES_ATAN_SIZE) / big];
+
+        if (ay > ax)
+        {
+                angle = CDTC_TABLES_SIN_SIZE / 4 - angle;
+        }
+        if (x < 0)
+        {
+                angle = CDTC_TABLES_SIN_SIZE / 2 - angle;
+        }
+        if (y < 0)
+        {
+                angle = -angle;
+        }
+
+        return CDTC_ANGLE(angle);
+}
+#endif
+
+#endif /* __CDTC_FIXED_TABLES_H__ */
@@ -0,0 +1,81 @@
+#ifndef __CDTC_MATH_H__
+#define __CDTC_MATH_H__
+
+#include <stdint.h>
+
+/** Fast multiplication with quarter squares.
+
+    x * y = floor((x + y)^2 / 4) - floor((x - y)^2 / 4)
+
+    so an 8-bit by 8-bit product is two lookups in a table of
+    floor(n^2 / 4) for n from 0 to 511 and a 16-bit subtraction, in
+    constant time, instead of SDCC's shift-and-add loop.  Wider
+    products are made of 8-bit ones.
+
+    Cost in NOPs, call and return included, compared with what SDCC
+    generates for the same product in C (__mulint does 8 or 16
+    shift-and-add steps, __mullong is generic 32-bit code):
+
+    function                     cdtc       SDCC
+    cdtc_mul_u8_u8__fastcall     40-41      about 150 (__mulint)
+    cdtc_mul_s8_s8__fastcall     47-53      about 270 (__mulint)
+    cdtc_mul_u16_u8__fastcall    about 100  over 1000 (__mullong)
+    cdtc_mul_u16_u16__fastcall   about 220  over 1000 (__mullong)
+
+    plus packing arguments at call site.  cdtc costs are counted from
+    instructions.  cpclib/cdtc/test/math_mul checks every 8-bit
+    product and displays timings when run.
+
+    The table takes 1 KB: 2 pages of low bytes then 2 pages of high
+    bytes, computed by the assembler, in linker area _CDTC_ALIGNED
+    which must start on a 256-byte boundary.  The area starts with
+    .bndry 256; if your linker does not honour it, set
+    CDTC_ALIGNED_LOC in cdtc_project.conf to a multiple of 0x100 where
+    the area is placed, e.g. CDTC_ALIGNED_LOC=0x3C00 below
+    CODELOC=0x4000.  CDTC_MATH_TABLES_ALIGNED tells at run time.
+
+    Arguments are packed in one fastcall parameter, see the macros
+    below which do it for you.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK: cpclib/cdtc/test/math_mul
+    has not been run on an emulator yet, its reference output is the
+    expected one, not a recorded run.
+*/
+
+/** Quarter squares floor(n * n / 4), low and high bytes, n from 0
+    to 511. */
+extern const uint8_t cdtc_math_quarter_square_low[512];
+extern const uint8_t cdtc_math_quarter_square_high[512];
+
+/** True if the tables are placed correctly. */
+#define CDTC_MATH_TABLES_ALIGNED (((uint16_t)cdtc_math_quarter_square_low & 0xFF) == 0)
+
+/** x in high byte, y in low byte. */
+uint16_t cdtc_mul_u8_u8__fastcall(uint16_t x_y) __z88dk_fastcall __preserves_regs(b, iyh, iyl);
+
+/** x in high byte, y in low byte, both signed. */
+int16_t cdtc_mul_s8_s8__fastcall(uint16_t x_y) __z88dk_fastcall __preserves_regs(b, iyh, iyl);
+
+/** y in bits 16-23, x in bits 0-15.  Result fits 24 bits. */
+uint32_t cdtc_mul_u16_u8__fastcall(uint32_t y_x) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** x in bits 16-31, y in bits 0-15. */
+uint32_t cdtc_mul_u16_u16__fastcall(uint32_t x_y) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+#define CDTC_MUL_U8_U8(x, y) cdtc_mul_u8_u8__fastcall(((uint16_t)(uint8_t)(x) << 8) | (uint8_t)(y))
+#define CDTC_MUL_S8_S8(x, y) cdtc_mul_s8_s8__fastcall(((uint16_t)(uint8_t)(x) << 8) | (uint8_t)(y))
+#define CDTC_MUL_U16_U8(x, y) cdtc_mul_u16_u8__fastcall(((uint32_t)(uint8_t)(y) << 16) | (uint16_t)(x))
+#define CDTC_MUL_U16_U16(x, y) cdtc_mul_u16_u16__fastcall(((uint32_t)(uint16_t)(x) << 16) | (uint16_t)(y))
+
+/** Inline variants in C, without a call, for hot loops where SDCC
+    keeps operands in registers.  Arguments are evaluated several
+    times. */
+#define CDTC_QUARTER_SQUARE(n) (((uint16_t)cdtc_math_quarter_square_high[(n)] << 8) | cdtc_math_quarter_square_low[(n)])
+
+#define CDTC_MUL_U8_U8_INLINE(x, y)                                     \
+        ((uint16_t)(CDTC_QUARTER_SQUARE((uint16_t)(uint8_t)(x) + (uint8_t)(y)) \
+                    - CDTC_QUARTER_SQUARE((uint8_t)(x) >= (uint8_t)(y)  \
+                                          ? (uint8_t)((x) - (y))        \
+                                          : (uint8_t)((y) - (x)))))
+
+#endif /* __CDTC_MATH_H__ */
@@ -0,0 +1,71 @@
+#ifndef __CDTC_RANDOM_H__
+#define __CDTC_RANDOM_H__
+
+#include <stdint.h>
+
+/** Fast pseudo-random number generators.
+
+    SDCC's rand() computes a 32-bit linear congruential generator
+    with the generic 32-bit multiplication, well over 1000 NOPs per
+    call.  These take 17 to 61 NOPs, call and return included:
+
+    function                            NOPs  period    state
+    cdtc_random_lfsr8__fastcall         17-18 255       uint8_t
+    cdtc_random_lfsr16__fastcall        30-31 65535     uint16_t
+    cdtc_random_xorshift16__fastcall    37    65535     uint16_t
+    cdtc_random_table8                  34    > 2^55    shared table
+    cdtc_random_table16                 61    > 2^55    shared table
+
+    Generators with a state take a pointer to it, so that independent
+    sequences can be kept, for example one replayed from the same seed
+    for level generation and one for effects.  A state must not be 0.
+    The table generators share a 256-byte page-aligned table in linker
+    area _CDTC_ALIGNED, see cdtc/math.h about CDTC_ALIGNED_LOC.
+
+    documentation-for-maintainers/random_quality/README.md reports
+    statistical tests of each generator and picks the defaults below:
+    only the table generators pass all tests.  LFSRs change one bit
+    per step, so consecutive values are strongly related: good enough
+    for noise or flicker, not for picking among choices.  xorshift16
+    has consecutive low bits related, and its period is too short to
+    judge its values.
+
+    Macros to inline the generators in assembly code are in
+    cpclib/cdtc/asminclude/cdtc/random.macros.s.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK: cpclib/cdtc/test/random
+    has not been run on an emulator yet, its reference output is the
+    expected one, not a recorded run.  The generators are checked on
+    the host against the models of the quality report.
+*/
+
+/** 8-bit Galois LFSR, taps 0xB8. */
+uint8_t cdtc_random_lfsr8__fastcall(uint8_t *state) __z88dk_fastcall __preserves_regs(b, c, d, e, iyh, iyl);
+
+/** 16-bit Galois LFSR, taps 0xB400. */
+uint16_t cdtc_random_lfsr16__fastcall(uint16_t *state) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** xorshift with shifts 7, 9, 8. */
+uint16_t cdtc_random_xorshift16__fastcall(uint16_t *state) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** Additive lagged Fibonacci generator x[n] = x[n - 24] + x[n - 55]
+    mod 256 on the shared table. */
+uint8_t cdtc_random_table8(void) __preserves_regs(b, c, iyh, iyl);
+
+/** Two bytes of cdtc_random_table8, low byte first. */
+uint16_t cdtc_random_table16(void) __preserves_regs(b, iyh, iyl);
+
+/** Fill the shared table from seed with xorshift16 and start from its
+    beginning.  Without it the table holds what seed 1 gives, read from
+    wherever the index happens to be at load: seed with a constant for a
+    sequence replayed at each run, or for example with
+    fw_kl_time_please() after waiting for a key. */
+void cdtc_random_table_seed(uint16_t seed) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** Defaults picked by the quality report, for 8-bit and 16-bit
+    values. */
+#define CDTC_RANDOM8() cdtc_random_table8()
+#define CDTC_RANDOM16() cdtc_random_table16()
+#define CDTC_RANDOM_SEED(seed) cdtc_random_table_seed((seed))
+
+#endif /* __CDTC_RANDOM_H__ */
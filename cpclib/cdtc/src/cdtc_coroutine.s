@@ -0,0 +1,234 @@
+.module cdtc_coroutine
+
+; Stackful cooperative coroutines, see cdtc/coroutine.h
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+; Control block, at the bottom of each stack slot:
+;   +0 saved SP
+;   +2 next coroutine in the ring when running, next free slot when free
+
+        .area _DATA
+
+_cdtc_coroutine_current::
+        .ds     2
+_cdtc_coroutine_alive::
+        .ds     1
+main_block:
+        .ds     4
+free_list:
+        .ds     2
+stack_size:
+        .ds     2
+
+        .area _CODE
+
+; void cdtc_coroutine_init(void *pool, uint16_t pool_size, uint16_t stack_size);
+_cdtc_coroutine_init::
+        ld      hl,#main_block
+        ld      (_cdtc_coroutine_current),hl
+        ld      (main_block+2),hl       ; ring of one
+        xor     a
+        ld      (_cdtc_coroutine_alive),a
+        ld      l,a
+        ld      h,a
+        ld      (free_list),hl
+
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      c,8(ix)
+        ld      b,9(ix)                 ; bc = stack_size
+        ld      (stack_size),bc
+        ld      e,6(ix)
+        ld      d,7(ix)                 ; de = pool_size
+        ld      l,4(ix)
+        ld      h,5(ix)                 ; hl = first slot
+
+        pop     ix
+
+carve:
+        ex      de,hl
+        or      a
+        sbc     hl,bc                   ; room for one more slot?
+        ret     c
+        ex      de,hl                   ; de = room left after it, hl = slot
+
+        push    de
+        ld      de,(free_list)
+        ld      (free_list),hl
+        push    hl
+        inc     hl
+        inc     hl
+        ld      (hl),e                  ; slot->next = previous free list
+        inc     hl
+        ld      (hl),d
+        pop     hl
+        add     hl,bc                   ; next slot
+        pop     de
+        jr      carve
+
+; cdtc_coroutine_t *cdtc_coroutine_create(cdtc_coroutine_entry_t entry, void *arg);
+_cdtc_coroutine_create::
+        ld      hl,(free_list)
+        ld      a,h
+        or      l
+        ret     z                       ; no slot left, NULL
+
+        ld      e,l
+        ld      d,h                     ; de = new control block
+        inc     hl
+        inc     hl
+        ld      a,(hl)
+        inc     hl
+        ld      h,(hl)
+        ld      l,a
+        ld      (free_list),hl
+
+        ld      hl,(stack_size)
+        add     hl,de                   ; top of the new stack
+
+        ; Initial stack, as if the coroutine was suspended right before
+        ; entering entry(arg) called from finish:
+        ; arg, finish, entry, IX, IY.
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        dec     hl
+        ld      a,7(ix)
+        ld      (hl),a
+        dec     hl
+        ld      a,6(ix)
+        ld      (hl),a                  ; arg
+        ld      bc,#finish
+        dec     hl
+        ld      (hl),b
+        dec     hl
+        ld      (hl),c                  ; return address of entry
+        dec     hl
+        ld      a,5(ix)
+        ld      (hl),a
+        dec     hl
+        ld      a,4(ix)
+        ld      (hl),a                  ; where the first switch returns to
+
+        pop     ix
+
+        ld      bc,#-4                  ; IX and IY, any value
+        add     hl,bc
+
+        ex      de,hl                   ; hl = control block, de = saved SP
+        ld      (hl),e
+        inc     hl
+        ld      (hl),d
+        inc     hl
+
+        ; Insert after the current coroutine.
+        ld      bc,(_cdtc_coroutine_current)
+        inc     bc
+        inc     bc
+        ld      a,(bc)
+        ld      (hl),a
+        inc     bc
+        inc     hl
+        ld      a,(bc)
+        ld      (hl),a                  ; new->next = current->next
+        dec     hl
+        dec     hl
+        dec     hl                      ; new
+        ld      a,h
+        ld      (bc),a
+        dec     bc
+        ld      a,l
+        ld      (bc),a                  ; current->next = new
+
+        ld      a,(_cdtc_coroutine_alive)
+        inc     a
+        ld      (_cdtc_coroutine_alive),a
+        ret
+
+; void cdtc_coroutine_yield(void);
+_cdtc_coroutine_yield::
+        ld      hl,(_cdtc_coroutine_current)    ; 5
+        inc     hl                              ; 2
+        inc     hl                              ; 2
+        ld      a,(hl)                          ; 2
+        inc     hl                              ; 2
+        ld      h,(hl)                          ; 2
+        ld      l,a                             ; 1, hl = current->next
+
+; void cdtc_coroutine_yield_to(cdtc_coroutine_t *coroutine) __z88dk_fastcall;
+_cdtc_coroutine_yield_to::
+        push    ix                              ; 5
+        push    iy                              ; 5
+        ex      de,hl                           ; 1
+        ld      hl,#0                           ; 3
+        add     hl,sp                           ; 3
+        ld      c,l                             ; 1
+        ld      b,h                             ; 1
+        ld      hl,(_cdtc_coroutine_current)    ; 5
+        ld      (hl),c                          ; 2
+        inc     hl                              ; 2
+        ld      (hl),b                          ; 2, current->sp = SP
+        ex      de,hl                           ; 1
+resume:
+        ld      (_cdtc_coroutine_current),hl    ; 5
+        ld      a,(hl)                          ; 2
+        inc     hl                              ; 2
+        ld      h,(hl)                          ; 2
+        ld      l,a                             ; 1
+        ld      sp,hl                           ; 2
+        pop     iy                              ; 4
+        pop     ix                              ; 4
+        ret                                     ; 3
+
+; A coroutine function returns here.  Unlink the coroutine from the
+; ring, give its slot back and resume the next one.  Its stack stays in
+; use until the switch, nothing can take the slot in the meantime.
+finish:
+        ld      de,(_cdtc_coroutine_current)
+        ld      l,e
+        ld      h,d
+find_previous:
+        ld      c,l
+        ld      b,h
+        inc     hl
+        inc     hl
+        ld      a,(hl)
+        inc     hl
+        ld      h,(hl)
+        ld      l,a
+        or      a
+        sbc     hl,de
+        add     hl,de
+        jr      nz,find_previous        ; bc = previous, de = finished
+
+        ex      de,hl
+        inc     hl
+        inc     hl
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)                  ; de = finished->next
+        ld      a,(free_list+1)
+        ld      (hl),a
+        dec     hl
+        ld      a,(free_list)
+        ld      (hl),a                  ; finished->next = free list
+        dec     hl
+        dec     hl
+        ld      (free_list),hl
+
+        inc     bc
+        inc     bc
+        ld      a,e
+        ld      (bc),a
+        inc     bc
+        ld      a,d
+        ld      (bc),a                  ; previous->next = finished->next
+
+        ld      hl,#_cdtc_coroutine_alive
+        dec     (hl)
+
+        ex      de,hl
+        jr      resume
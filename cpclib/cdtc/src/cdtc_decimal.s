@@ -0,0 +1,53 @@
+.module cdtc_decimal
+
+; 16-bit unsigned to decimal by subtracting powers of ten.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _CODE
+
+; char *cdtc_u16_to_decimal__fastcall(uint32_t buffer_x) __z88dk_fastcall;
+; in: hl = x, de = buffer of 6 bytes
+; out: buffer = 5 digits with leading zeros then 0,
+;      hl = first digit that is not a leading zero
+; 7 NOPs per unit of the first four digits, 140 to 370 NOPs
+_cdtc_u16_to_decimal__fastcall::
+        push    de              ; 4
+        ld      bc,#-10000      ; 3
+        call    digit           ; 5
+        ld      bc,#-1000       ; 3
+        call    digit           ; 5
+        ld      bc,#-100        ; 3
+        call    digit           ; 5
+        ld      c,#-10          ; 2
+        call    digit           ; 5
+        ld      a,l             ; 1
+        add     a,#'0           ; 2
+        ld      (de),a          ; 2
+        inc     de              ; 2
+        xor     a               ; 1
+        ld      (de),a          ; 2, terminator
+
+        pop     hl              ; 3
+        ld      b,#4            ; 2, keep at least one digit
+skip$:
+        ld      a,(hl)          ; 2
+        cp      #'0             ; 2
+        ret     nz              ; 2/4
+        inc     hl              ; 2
+        djnz    skip$           ; 4/3
+        ret                     ; 3
+
+; Write one digit of hl for power of ten -bc, leave the rest in hl.
+; in: hl = value, bc = minus power of ten, de = where to write the digit
+; out: hl = value modulo power of ten, de = next digit
+; corrupts: af
+digit:
+        ld      a,#'0-1         ; 2
+loop$:
+        inc     a               ; 1
+        add     hl,bc           ; 3
+        jr      c,loop$         ; 3/2
+        sbc     hl,bc           ; 4, carry is clear: undo last add
+        ld      (de),a          ; 2
+        inc     de              ; 2
+        ret                     ; 3
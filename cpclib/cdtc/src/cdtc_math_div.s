@@ -0,0 +1,115 @@
+.module cdtc_math_div
+
+; Restoring division, unrolled, and division by 10 by multiply-shift.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+; One quotient bit of hl / c: shift the next dividend bit of hl into
+; a, subtract c if possible and set the quotient bit in hl.  If a
+; overflows 8 bits it is larger than c anyway.  9 to 11 NOPs.
+        .macro  DIV_U8_STEP
+        add     hl,hl           ; 3
+        rla                     ; 1
+        jr      c,.+5           ; 3/2, to sub
+        cp      c               ; 1
+        jr      c,.+4           ; 3/2, to next step
+        sub     c               ; 1
+        inc     l               ; 1
+        .endm
+
+; One quotient bit of ac / de, remainder in hl: shift the next
+; dividend bit of ac into hl, subtract de if possible and set the
+; quotient bit in c.  If hl overflows 16 bits it is larger than de
+; anyway.  16 to 21 NOPs.
+        .macro  DIV_U16_STEP
+        sla     c               ; 2
+        rla                     ; 1
+        adc     hl,hl           ; 4
+        jr      c,.+9           ; 3/2, to or
+        sbc     hl,de           ; 4
+        jr      nc,.+8          ; 3/2, to inc
+        add     hl,de           ; 3
+        jr      .+6             ; 3, to next step
+        or      a               ; 1
+        sbc     hl,de           ; 4
+        inc     c               ; 1
+        .endm
+
+        .area _CODE
+
+; uint32_t cdtc_divmod_u16_u8__fastcall(uint32_t y_x) __z88dk_fastcall;
+; in: hl = x, e = y
+; out: hl = x / y, e = x % y, d = 0
+; 180 to 200 NOPs
+_cdtc_divmod_u16_u8__fastcall::
+        ld      c,e             ; 1
+        xor     a               ; 1
+        .rept   16
+        DIV_U8_STEP             ; 9-11
+        .endm
+        ld      e,a             ; 1
+        ld      d,#0            ; 2
+        ret                     ; 3
+
+; uint32_t cdtc_divmod_u16_u16__fastcall(uint32_t x_y) __z88dk_fastcall;
+; in: de = x, hl = y
+; out: hl = x / y, de = x % y
+; 280 to 360 NOPs
+_cdtc_divmod_u16_u16__fastcall::
+        ld      a,d             ; 1
+        ld      c,e             ; 1, ac = x
+        ex      de,hl           ; 1, de = y
+        ld      hl,#0           ; 3
+        .rept   16
+        DIV_U16_STEP            ; 16-21
+        .endm
+        ex      de,hl           ; 1
+        ld      h,a             ; 1
+        ld      l,c             ; 1
+        ret                     ; 3
+
+; uint32_t cdtc_div10_u16__fastcall(uint16_t x) __z88dk_fastcall;
+; in: hl = x
+; out: hl = x / 10, e = x % 10, d = 0
+; q = x * 0.8 / 8 with 0.8 = 0.11001100110011... in binary, low
+; enough that x - 10 * q is from 0 to 19.  Exact for all 16-bit x.
+; About 85 NOPs.
+_cdtc_div10_u16__fastcall::
+        ld      c,l             ; 1
+        srl     h               ; 2
+        rr      l               ; 2, x / 2
+        ld      d,h             ; 1
+        ld      e,l             ; 1
+        srl     d               ; 2
+        rr      e               ; 2, x / 4
+        add     hl,de           ; 3, q = x * 0.11b
+        ld      d,h             ; 1
+        ld      e,l             ; 1
+        .rept   4
+        srl     d               ; 2
+        rr      e               ; 2
+        .endm
+        add     hl,de           ; 3, q = x * 0.11001100b
+        ld      e,h             ; 1
+        ld      d,#0            ; 2
+        add     hl,de           ; 3, q = x * 0.1100110011001100b
+        .rept   3
+        srl     h               ; 2
+        rr      l               ; 2
+        .endm
+        ld      d,h             ; 1
+        ld      e,l             ; 1, de = q
+        add     hl,hl           ; 3
+        add     hl,hl           ; 3
+        add     hl,de           ; 3
+        add     hl,hl           ; 3, 10 * q
+        ld      a,c             ; 1
+        sub     l               ; 1, x - 10 * q fits 8 bits
+        ex      de,hl           ; 1
+        cp      #10             ; 2
+        jr      c,done$         ; 3/2
+        sub     #10             ; 2
+        inc     hl              ; 2
+done$:
+        ld      e,a             ; 1
+        ld      d,#0            ; 2
+        ret                     ; 3
@@ -0,0 +1,150 @@
+.module cdtc_math_mul
+
+; Multiplication with quarter squares:
+; x * y = floor((x + y)^2 / 4) - floor((x - y)^2 / 4)
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .globl  _cdtc_math_quarter_square_low
+
+QSL = _cdtc_math_quarter_square_low
+
+; hl = f(hl) - f(e), f being the quarter square table, hl pointing
+; into its low bytes
+; corrupts: af, c, de
+        .macro  QS_DIFF
+        ld      d,#>QSL         ; 2
+        ex      de,hl           ; 1, de = f(x + y), hl = f(|x - y|)
+        ld      a,(de)          ; 2
+        sub     (hl)            ; 2
+        ld      c,a             ; 1
+        inc     h               ; 1
+        inc     h               ; 1
+        inc     d               ; 1
+        inc     d               ; 1, high bytes
+        ld      a,(de)          ; 2
+        sbc     a,(hl)          ; 2
+        ld      h,a             ; 1
+        ld      l,c             ; 1
+        .endm
+
+; hl = h * l, unsigned, 32 or 33 NOPs
+; corrupts: af, c, de
+        .macro  MUL8
+        ld      a,h             ; 1
+        sub     l               ; 1
+        jr      nc,.+4          ; 3/2
+        neg                     ; 2
+        ld      e,a             ; 1, |x - y|
+        ld      a,h             ; 1
+        add     a,l             ; 1
+        ld      l,a             ; 1
+        ld      a,#>QSL         ; 2
+        adc     a,#0            ; 2
+        ld      h,a             ; 1, x + y on 9 bits
+        QS_DIFF                 ; 18
+        .endm
+
+        .area _CODE
+
+; uint16_t cdtc_mul_u8_u8__fastcall(uint16_t x_y) __z88dk_fastcall;
+_cdtc_mul_u8_u8__fastcall::
+        MUL8
+        ret
+
+; int16_t cdtc_mul_s8_s8__fastcall(uint16_t x_y) __z88dk_fastcall;
+_cdtc_mul_s8_s8__fastcall::
+        ld      a,h             ; 1
+        xor     #0x80           ; 2
+        ld      h,a             ; 1, x + 128
+        ld      a,l             ; 1
+        xor     #0x80           ; 2
+        ld      l,a             ; 1, y + 128
+        sub     h               ; 1
+        jr      nc,.+4          ; 3/2
+        neg                     ; 2
+        ld      e,a             ; 1, |x - y|
+        ld      a,h             ; 1
+        add     a,l             ; 1, x + y + 256
+        jr      c,positive$     ; 3/2
+        neg                     ; 2, -(x + y), carry unless x + y = -256
+        ccf                     ; 1
+        ld      l,a             ; 1
+        ld      a,#>QSL         ; 2
+        adc     a,#0            ; 2
+        ld      h,a             ; 1, |x + y| on 9 bits
+        QS_DIFF                 ; 18
+        ret                     ; 3
+positive$:
+        ld      l,a             ; 1
+        ld      h,#>QSL         ; 2, x + y
+        QS_DIFF                 ; 18
+        ret                     ; 3
+
+; uint32_t cdtc_mul_u16_u8__fastcall(uint32_t y_x) __z88dk_fastcall;
+_cdtc_mul_u16_u8__fastcall::
+        ld      b,e             ; y
+        ld      a,h
+        push    af              ; x high
+        ld      h,b
+        MUL8                    ; x low * y
+        pop     af
+        push    hl
+        ld      h,a
+        ld      l,b
+        MUL8                    ; x high * y
+        pop     de
+        ld      a,d             ; x low * y + (x high * y << 8)
+        add     a,l
+        ld      l,e
+        ld      e,h
+        ld      h,a
+        ld      d,#0
+        ret     nc
+        inc     e               ; x high * y <= 0xFE01, no carry out
+        ret
+
+; uint32_t cdtc_mul_u16_u16__fastcall(uint32_t x_y) __z88dk_fastcall;
+_cdtc_mul_u16_u16__fastcall::
+        push    hl              ; y
+        push    de              ; x
+        ld      h,e
+        MUL8                    ; A = x low * y low
+        pop     de
+        ex      (sp),hl         ; A
+        push    hl              ; y
+        push    de              ; x
+        ld      l,d
+        MUL8                    ; D = x high * y high
+        pop     de
+        ex      (sp),hl         ; D, A
+        ld      b,h
+        ld      h,d
+        push    de              ; x
+        MUL8                    ; C = x high * y low
+        pop     de
+        push    hl              ; C, D, A
+        ld      h,b
+        ld      l,e
+        MUL8                    ; B = x low * y high
+        pop     de
+        add     hl,de           ; M = B + C, carry is bit 16
+
+        pop     de              ; D, result is (D << 16) + (M << 8) + A
+        ld      a,#0
+        adc     a,d
+        ld      d,a
+        ld      c,l
+        ld      a,e
+        add     a,h
+        ld      e,a
+        jr      nc,.+3
+        inc     d
+        pop     hl              ; A
+        ld      a,h
+        add     a,c
+        ld      h,a
+        ret     nc
+        inc     e
+        ret     nz
+        inc     d
+        ret
@@ -0,0 +1,27 @@
+.module cdtc_math_quarter_squares
+
+; Quarter squares floor(n * n / 4) for n = 0 to 511, computed by the
+; assembler: low bytes (2 pages) then high bytes (2 pages).
+; floor((n + 1)^2 / 4) - floor(n^2 / 4) = floor((n + 1) / 2)
+
+        .area _CDTC_ALIGNED
+
+        .bndry  256
+
+_cdtc_math_quarter_square_low::
+n = 0
+q = 0
+        .rept   512
+        .db     <q
+n = n + 1
+q = q + (n / 2)
+        .endm
+
+_cdtc_math_quarter_square_high::
+n = 0
+q = 0
+        .rept   512
+        .db     >q
+n = n + 1
+q = q + (n / 2)
+        .endm
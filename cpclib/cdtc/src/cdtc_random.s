@@ -0,0 +1,112 @@
+.module cdtc_random
+
+; Pseudo-random number generators, see cdtc/random.h and
+; cdtc/random.macros.s.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .include "cdtc/random.macros.s"
+
+        .area _CDTC_ALIGNED
+
+; Content left by cdtc_random_table_seed(1), computed by the
+; assembler, so that the table generators work without seeding.  Every
+; 55 consecutive values hold odd ones, so any starting index gives the
+; full period.
+        .bndry  256
+_cdtc_random_table::
+x = 1
+x = x ^ ((x << 7) & 0xFFFF)
+x = x ^ (x >> 9)
+x = x ^ ((x << 8) & 0xFFFF)
+        .db     (x >> 8) | 1
+        .rept   255
+x = x ^ ((x << 7) & 0xFFFF)
+x = x ^ (x >> 9)
+x = x ^ ((x << 8) & 0xFFFF)
+        .db     x >> 8
+        .endm
+
+        .area _DATA
+
+_cdtc_random_table_index::
+        .ds     1
+
+        .area _CODE
+
+; uint8_t cdtc_random_lfsr8__fastcall(uint8_t *state) __z88dk_fastcall;
+; 17 or 18 NOPs
+_cdtc_random_lfsr8__fastcall::
+        ld      a,(hl)          ; 2
+        CDTC_RANDOM_LFSR8       ; 4-5
+        ld      (hl),a          ; 2
+        ld      l,a             ; 1
+        ret                     ; 3
+
+; uint16_t cdtc_random_lfsr16__fastcall(uint16_t *state) __z88dk_fastcall;
+; 30 or 31 NOPs
+_cdtc_random_lfsr16__fastcall::
+        ld      e,(hl)          ; 2
+        inc     hl              ; 2
+        ld      d,(hl)          ; 2
+        ex      de,hl           ; 1, de = state + 1
+        CDTC_RANDOM_LFSR16      ; 7-8
+        ex      de,hl           ; 1
+        ld      (hl),d          ; 2
+        dec     hl              ; 2
+        ld      (hl),e          ; 2
+        ex      de,hl           ; 1
+        ret                     ; 3
+
+; uint16_t cdtc_random_xorshift16__fastcall(uint16_t *state) __z88dk_fastcall;
+; 37 NOPs
+_cdtc_random_xorshift16__fastcall::
+        ld      e,(hl)          ; 2
+        inc     hl              ; 2
+        ld      d,(hl)          ; 2
+        ex      de,hl           ; 1, de = state + 1
+        CDTC_RANDOM_XORSHIFT16  ; 14
+        ex      de,hl           ; 1
+        ld      (hl),d          ; 2
+        dec     hl              ; 2
+        ld      (hl),e          ; 2
+        ex      de,hl           ; 1
+        ret                     ; 3
+
+; uint8_t cdtc_random_table8(void);
+; 34 NOPs
+_cdtc_random_table8::
+        CDTC_RANDOM_TABLE8      ; 25
+        ld      l,a             ; 1
+        ret                     ; 3
+
+; uint16_t cdtc_random_table16(void);
+; 61 NOPs
+_cdtc_random_table16::
+        CDTC_RANDOM_TABLE8      ; 25
+        ld      c,a             ; 1
+        CDTC_RANDOM_TABLE8      ; 25
+        ld      h,a             ; 1
+        ld      l,c             ; 1
+        ret                     ; 3
+
+; void cdtc_random_table_seed(uint16_t seed) __z88dk_fastcall;
+; Fill the table from xorshift16 started at seed, 0 counting as 1,
+; with at least one odd value in the 55 last ones, else the lowest
+; bit of the sequence would stay 0.
+_cdtc_random_table_seed::
+        ld      a,h
+        or      l
+        jr      nz,.+3          ; to ld
+        inc     l
+        ld      de,#_cdtc_random_table
+fill$:
+        CDTC_RANDOM_XORSHIFT16  ; a = h
+        ld      (de),a
+        inc     e
+        jr      nz,fill$
+        ld      a,(de)          ; table[0], the last value before table[1]
+        or      #1
+        ld      (de),a
+        xor     a
+        ld      (_cdtc_random_table_index),a
+        ret
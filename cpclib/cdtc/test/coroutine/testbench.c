@@ -0,0 +1,21 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+#include "cdtc/coroutine.h"
+
+void run_round_robin( void );
+void run_slot_reuse( void );
+
+void
+main()
+{
+        fw_mc_send_printer( '0' );
+
+        run_round_robin();
+
+        fw_mc_send_printer( '1' );
+
+        run_slot_reuse();
+
+        fw_mc_send_printer( '2' );
+        fw_mc_wait_flyback();
+}
@@ -0,0 +1,73 @@
+#include "cfwi/cfwi.h"
+#include "cdtc/coroutine.h"
+#include "stdint.h"
+
+#define STACK_SIZE 128
+#define SLOT_COUNT 3
+
+static uint8_t pool[SLOT_COUNT * STACK_SIZE];
+
+typedef struct task_t
+{
+        char letter;
+        uint8_t rounds;
+} task_t;
+
+static const task_t tasks[] = { { 'a', 3 }, { 'b', 2 }, { 'c', 1 } };
+
+/* Locals and arguments live in the IX frame: they would be wrong
+   after a yield if IX was not switched with the stack. */
+void task( void *arg )
+{
+        const task_t *t = arg;
+        uint8_t i;
+
+        for ( i = 0; i < t->rounds; i++ )
+        {
+                fw_mc_send_printer( t->letter );
+                cdtc_coroutine_yield();
+        }
+}
+
+/* Coroutines are created in front of main, so they run in reverse
+   creation order.  Expected: mcba mba ma m */
+void run_round_robin()
+{
+        uint8_t i;
+
+        cdtc_coroutine_init( pool, sizeof( pool ), STACK_SIZE );
+
+        for ( i = 0; i < SLOT_COUNT; i++ )
+        {
+                cdtc_coroutine_create( task, ( void * ) &tasks[i] );
+        }
+
+        /* All slots are taken. */
+        fw_mc_send_printer( ( cdtc_coroutine_create( task, ( void * ) &tasks[0] ) == 0 ) ? 'N' : 'X' );
+
+        while ( cdtc_coroutine_alive != 0 )
+        {
+                fw_mc_send_printer( 'm' );
+                cdtc_coroutine_yield();
+        }
+}
+
+/* Finished coroutines gave their slots back.  Expected: mcba mba ma m */
+void run_slot_reuse()
+{
+        uint8_t i;
+
+        for ( i = 0; i < SLOT_COUNT; i++ )
+        {
+                if ( cdtc_coroutine_create( task, ( void * ) &tasks[i] ) == 0 )
+                {
+                        fw_mc_send_printer( 'X' );
+                }
+        }
+
+        while ( cdtc_coroutine_alive != 0 )
+        {
+                fw_mc_send_printer( 'm' );
+                cdtc_coroutine_yield();
+        }
+}
@@ -0,0 +1,24 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+#include "cdtc/fixed_tables.h"
+
+void check_alignment( void );
+void check_sin_cos( void );
+void check_atan2( void );
+void check_recip( void );
+void check_sqrt( void );
+
+void
+main()
+{
+        fw_mc_send_printer( '0' );
+
+        check_alignment();
+        check_sin_cos();
+        check_atan2();
+        check_recip();
+        check_sqrt();
+
+        fw_mc_send_printer( '1' );
+        fw_mc_wait_flyback();
+}
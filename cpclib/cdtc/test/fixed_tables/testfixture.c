@@ -0,0 +1,132 @@
+#include "cfwi/cfwi.h"
+#include "cdtc/fixed_tables.h"
+#include "stdint.h"
+
+#define hexchar(i) ( ( (i) < 10 ) ? ( '0' + (i) ) : ( 'A' - 10 + (i) ) )
+
+static uint16_t errors;
+
+/* Group letter then 'k', or '!' and the error count in hex. */
+static void report( char group )
+{
+        fw_mc_send_printer( group );
+
+        if ( errors == 0 )
+        {
+                fw_mc_send_printer( 'k' );
+                return;
+        }
+
+        fw_mc_send_printer( '!' );
+        fw_mc_send_printer( hexchar( ( errors >> 12 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 8 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 4 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( errors & 0x0F ) );
+        errors = 0;
+}
+
+static void check( uint8_t condition )
+{
+        if ( !condition )
+        {
+                errors++;
+        }
+}
+
+/* Expected: A */
+void check_alignment()
+{
+        fw_mc_send_printer( CDTC_FIXED_TABLE_ALIGNED( cdtc_sin_low )
+                            && CDTC_FIXED_TABLE_ALIGNED( cdtc_atan_octant )
+                            && CDTC_FIXED_TABLE_ALIGNED( cdtc_recip_low )
+                            && CDTC_FIXED_TABLE_ALIGNED( cdtc_sqrt_low ) ? 'A' : 'U' );
+}
+
+/* Symmetries, extremes and sin^2 + cos^2 = 1.  Expected: Sk */
+void check_sin_cos()
+{
+        uint8_t a = 0;
+
+        check( CDTC_SIN( 0 ) == 0 );
+        check( CDTC_SIN( 64 ) == 256 );
+        check( CDTC_SIN( 192 ) == -256 );
+        check( CDTC_COS( 0 ) == 256 );
+        check( CDTC_COS( 128 ) == -256 );
+
+        do
+        {
+                int16_t s = CDTC_SIN( a );
+                int16_t c = CDTC_COS( a );
+                int32_t norm = ( int32_t ) s * s + ( int32_t ) c * c;
+
+                check( CDTC_SIN( a + 128 ) == -s );
+                check( CDTC_SIN( 128 - a ) == s );
+                check( c == CDTC_SIN( a + 64 ) );
+                check( norm > 65536 - 512 && norm < 65536 + 512 );
+        }
+        while ( ++a != 0 );
+
+        report( 'S' );
+}
+
+/* Axes, diagonals, then back from every angle.  Expected: Tk */
+void check_atan2()
+{
+        uint8_t a = 0;
+
+        check( cdtc_atan2( 0, 5 ) == 0 );
+        check( cdtc_atan2( 5, 5 ) == 32 );
+        check( cdtc_atan2( 5, 0 ) == 64 );
+        check( cdtc_atan2( 5, -5 ) == 96 );
+        check( cdtc_atan2( 0, -5 ) == 128 );
+        check( cdtc_atan2( -5, -5 ) == 160 );
+        check( cdtc_atan2( -5, 0 ) == 192 );
+        check( cdtc_atan2( -5, 5 ) == 224 );
+        check( cdtc_atan2( 30000, 30000 ) == 32 );
+        check( cdtc_atan2( -32768, 0 ) == 192 );
+        check( cdtc_atan2( 0, 0 ) == 0 );
+
+        do
+        {
+                uint8_t back = cdtc_atan2( CDTC_SIN( a ), CDTC_COS( a ) );
+
+                check( ( uint8_t ) ( back - a + 1 ) <= 2 );
+        }
+        while ( ++a != 0 );
+
+        report( 'T' );
+}
+
+/* i * recip(i) is 65536 within rounding.  Expected: Rk */
+void check_recip()
+{
+        uint16_t i;
+
+        check( CDTC_RECIP( 0 ) == 0xFFFF );
+        check( CDTC_RECIP( 1 ) == 0xFFFF );
+
+        for ( i = 2; i < 256; i++ )
+        {
+                int32_t d = ( int32_t ) CDTC_RECIP( i ) * i - 65536L;
+
+                check( d >= -( int32_t ) i && d <= ( int32_t ) i );
+        }
+
+        report( 'R' );
+}
+
+/* sqrt(i)^2 is i within rounding.  Expected: Qk */
+void check_sqrt()
+{
+        uint16_t i;
+
+        for ( i = 0; i < 256; i++ )
+        {
+                uint16_t q = CDTC_SQRT( i );
+                int32_t d = ( int32_t ) ( ( uint32_t ) q * q - ( ( uint32_t ) i << 16 ) );
+
+                check( d >= -( int32_t ) q && d <= ( int32_t ) q );
+        }
+
+        report( 'Q' );
+}
@@ -0,0 +1,29 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+#include "cdtc/div.h"
+
+void check_u16_u8( void );
+void check_u16_u16( void );
+void check_div10( void );
+void check_u8_const( void );
+void check_decimal( void );
+void benchmark( void );
+
+void
+main()
+{
+        fw_mc_send_printer( '0' );
+
+        check_u16_u8();
+        check_u16_u16();
+        check_div10();
+        check_u8_const();
+        check_decimal();
+
+        fw_mc_send_printer( '1' );
+
+        benchmark();
+
+        fw_mc_send_printer( '2' );
+        fw_mc_wait_flyback();
+}
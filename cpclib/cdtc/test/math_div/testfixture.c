@@ -0,0 +1,257 @@
+#include "cfwi/cfwi.h"
+#include "cdtc/div.h"
+#include "stdint.h"
+
+#define hexchar(i) ( ( (i) < 10 ) ? ( '0' + (i) ) : ( 'A' - 10 + (i) ) )
+
+static uint16_t errors;
+
+/* Group letter then 'k', or '!' and the error count in hex. */
+static void report( char group )
+{
+        fw_mc_send_printer( group );
+
+        if ( errors == 0 )
+        {
+                fw_mc_send_printer( 'k' );
+                return;
+        }
+
+        fw_mc_send_printer( '!' );
+        fw_mc_send_printer( hexchar( ( errors >> 12 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 8 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 4 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( errors & 0x0F ) );
+        errors = 0;
+}
+
+/* Every divisor with 262 dividends, multiples of 0xFB from 0 to
+   0xFFFF, then division by zero.  Expected: Bk */
+void check_u16_u8()
+{
+        uint8_t y = 1;
+
+        do
+        {
+                uint16_t x = 0;
+
+                do
+                {
+                        uint32_t r = CDTC_DIVMOD_U16_U8( x, y );
+
+                        if ( ( uint16_t ) r != x / y || ( uint16_t ) ( r >> 16 ) != x % y )
+                        {
+                                errors++;
+                        }
+                        x += 0xFB;
+                }
+                while ( x >= 0xFB );
+
+                if ( CDTC_DIV_U16_U8( 0xFFFF, y ) != 0xFFFF / y )
+                {
+                        errors++;
+                }
+        }
+        while ( ++y != 0 );
+
+        if ( CDTC_DIVMOD_U16_U8( 1234, 0 ) != ( ( uint32_t ) ( 1234 & 0xFF ) << 16 | 0xFFFF ) )
+        {
+                errors++;
+        }
+
+        report( 'B' );
+}
+
+/* Edge cases then 16384 pseudo-random pairs.  Expected: Wk */
+void check_u16_u16()
+{
+        static const uint16_t edges[] = { 1, 2, 0xFF, 0x100, 0x7FFF, 0x8000, 0x8001, 0xFFFE, 0xFFFF };
+        uint16_t x = 1;
+        uint16_t y = 0xACE1;
+        uint16_t i;
+        uint8_t a, b;
+
+        for ( a = 0; a < sizeof( edges ) / sizeof( edges[0] ); a++ )
+        {
+                for ( b = 0; b < sizeof( edges ) / sizeof( edges[0] ); b++ )
+                {
+                        uint32_t r = CDTC_DIVMOD_U16_U16( edges[a], edges[b] );
+
+                        if ( ( uint16_t ) r != edges[a] / edges[b] || ( uint16_t ) ( r >> 16 ) != edges[a] % edges[b] )
+                        {
+                                errors++;
+                        }
+                }
+        }
+
+        for ( i = 0; i < 16384; i++ )
+        {
+                uint32_t r;
+
+                /* xorshift */
+                x ^= x << 7;
+                x ^= x >> 9;
+                x ^= x << 8;
+                y += x ^ 0x5A5A;
+                if ( i & 1 )
+                {
+                        y &= 0x3FF;
+                }
+                if ( y == 0 )
+                {
+                        y = 1;
+                }
+
+                r = CDTC_DIVMOD_U16_U16( x, y );
+                if ( ( uint16_t ) r != x / y || ( uint16_t ) ( r >> 16 ) != x % y )
+                {
+                        errors++;
+                }
+        }
+
+        if ( CDTC_DIVMOD_U16_U16( 1234, 0 ) != ( ( uint32_t ) 1234 << 16 | 0xFFFF ) )
+        {
+                errors++;
+        }
+
+        report( 'W' );
+}
+
+/* Every dividend.  Expected: Tk */
+void check_div10()
+{
+        uint16_t x = 0;
+
+        do
+        {
+                if ( CDTC_DIV10_U16( x ) != x / 10 || CDTC_MOD10_U16( x ) != x % 10 )
+                {
+                        errors++;
+                }
+        }
+        while ( ++x != 0 );
+
+        report( 'T' );
+}
+
+#define CHECK_U8_CONST( d )                                             \
+        do                                                              \
+        {                                                               \
+                uint8_t x = 0;                                          \
+                do                                                      \
+                {                                                       \
+                        if ( CDTC_DIV_U8_CONST( x, d ) != x / ( d )     \
+                             || CDTC_MOD_U8_CONST( x, d ) != x % ( d ) ) \
+                        {                                               \
+                                errors++;                               \
+                        }                                               \
+                }                                                       \
+                while ( ++x != 0 );                                     \
+        }                                                               \
+        while ( 0 )
+
+/* Every dividend for a few divisors.  Expected: Ck */
+void check_u8_const()
+{
+        CHECK_U8_CONST( 1 );
+        CHECK_U8_CONST( 2 );
+        CHECK_U8_CONST( 3 );
+        CHECK_U8_CONST( 5 );
+        CHECK_U8_CONST( 6 );
+        CHECK_U8_CONST( 7 );
+        CHECK_U8_CONST( 10 );
+        CHECK_U8_CONST( 100 );
+        CHECK_U8_CONST( 129 );
+        CHECK_U8_CONST( 255 );
+
+        report( 'C' );
+}
+
+/* Digits give back the value, leading zeros are skipped.  Expected:
+   Dk */
+void check_decimal()
+{
+        char buffer[6];
+        uint16_t x = 0;
+
+        do
+        {
+                char *s = CDTC_U16_TO_DECIMAL( buffer, x );
+                uint16_t v = 0;
+                uint8_t i;
+
+                for ( i = 0; i < 5; i++ )
+                {
+                        v = v * 10 + ( buffer[i] - '0' );
+                }
+
+                if ( v != x || buffer[5] != 0 || s < buffer || s > buffer + 4
+                     || ( s != buffer + 4 && *s == '0' ) || ( s != buffer && s[-1] != '0' ) )
+                {
+                        errors++;
+                }
+                x += 7;
+        }
+        while ( x >= 7 );
+
+        report( 'D' );
+}
+
+static void screen_hex16( uint16_t v )
+{
+        fw_txt_output( hexchar( ( v >> 12 ) & 0x0F ) );
+        fw_txt_output( hexchar( ( v >> 8 ) & 0x0F ) );
+        fw_txt_output( hexchar( ( v >> 4 ) & 0x0F ) );
+        fw_txt_output( hexchar( v & 0x0F ) );
+}
+
+static void screen_str( const char *s )
+{
+        while ( *s )
+        {
+                fw_txt_output( *s++ );
+        }
+}
+
+static volatile uint16_t sink16;
+static volatile uint32_t sink32;
+static volatile uint8_t sink8;
+static volatile uint8_t opx = 234;
+static volatile uint8_t opy = 13;
+static volatile uint16_t opx16 = 54321;
+static volatile uint16_t opy16 = 1234;
+static char decimal[6];
+
+#define ROUNDS 3000
+
+/* Times ROUNDS operations of each kind in 1/300 s, on screen only as
+   they depend on the machine or emulator. */
+#define TIME( label, statement )                                        \
+        do                                                              \
+        {                                                               \
+                uint16_t r;                                             \
+                uint32_t t0 = fw_kl_time_please();                      \
+                for ( r = 0; r < ROUNDS; r++ )                          \
+                {                                                       \
+                        statement;                                      \
+                }                                                       \
+                screen_str( label );                                    \
+                screen_hex16( fw_kl_time_please() - t0 );               \
+                screen_str( "\r\n" );                                   \
+        }                                                               \
+        while ( 0 )
+
+void benchmark()
+{
+        screen_str( "3000 operations, 1/300 s\r\n" );
+        TIME( "empty loop     ", sink16 = opx16 );
+        TIME( "u16/u8  C      ", sink16 = opx16 / opy; sink8 = opx16 % opy );
+        TIME( "u16/u8  cdtc   ", sink32 = CDTC_DIVMOD_U16_U8( opx16, opy ) );
+        TIME( "u16/u16 C      ", sink16 = opx16 / opy16; sink16 = opx16 % opy16 );
+        TIME( "u16/u16 cdtc   ", sink32 = CDTC_DIVMOD_U16_U16( opx16, opy16 ) );
+        TIME( "u16/10  C      ", sink16 = opx16 / 10; sink8 = opx16 % 10 );
+        TIME( "u16/10  cdtc   ", sink32 = cdtc_div10_u16__fastcall( opx16 ) );
+        TIME( "u8/10   C      ", sink8 = opx / 10 );
+        TIME( "u8/10   cdtc   ", sink8 = CDTC_DIV_U8_CONST( opx, 10 ) );
+        TIME( "decimal cdtc   ", sink16 = ( uint16_t ) CDTC_U16_TO_DECIMAL( decimal, opx16 ) );
+}
@@ -0,0 +1,31 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+#include "cdtc/math.h"
+
+void check_tables( void );
+void check_u8_u8( void );
+void check_inline( void );
+void check_s8_s8( void );
+void check_u16_u8( void );
+void check_u16_u16( void );
+void benchmark( void );
+
+void
+main()
+{
+        fw_mc_send_printer( '0' );
+
+        check_tables();
+        check_u8_u8();
+        check_inline();
+        check_s8_s8();
+        check_u16_u8();
+        check_u16_u16();
+
+        fw_mc_send_printer( '1' );
+
+        benchmark();
+
+        fw_mc_send_printer( '2' );
+        fw_mc_wait_flyback();
+}
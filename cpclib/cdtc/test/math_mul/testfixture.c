@@ -0,0 +1,232 @@
+#include "cfwi/cfwi.h"
+#include "cdtc/math.h"
+#include "stdint.h"
+
+#define hexchar(i) ( ( (i) < 10 ) ? ( '0' + (i) ) : ( 'A' - 10 + (i) ) )
+
+static uint16_t errors;
+
+/* Group letter then 'k', or '!' and the error count in hex. */
+static void report( char group )
+{
+        fw_mc_send_printer( group );
+
+        if ( errors == 0 )
+        {
+                fw_mc_send_printer( 'k' );
+                return;
+        }
+
+        fw_mc_send_printer( '!' );
+        fw_mc_send_printer( hexchar( ( errors >> 12 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 8 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 4 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( errors & 0x0F ) );
+        errors = 0;
+}
+
+/* Expected: A */
+void check_tables()
+{
+        uint16_t n;
+
+        fw_mc_send_printer( CDTC_MATH_TABLES_ALIGNED ? 'A' : 'U' );
+
+        for ( n = 0; n < 512; n++ )
+        {
+                if ( CDTC_QUARTER_SQUARE( n ) != ( uint16_t ) ( ( ( uint32_t ) n * n ) >> 2 ) )
+                {
+                        errors++;
+                }
+        }
+
+        report( 'T' );
+}
+
+/* Every product.  Expected: Uk */
+void check_u8_u8()
+{
+        uint8_t x = 0;
+
+        do
+        {
+                uint8_t y = 0;
+
+                do
+                {
+                        if ( CDTC_MUL_U8_U8( x, y ) != ( uint16_t ) x * y )
+                        {
+                                errors++;
+                        }
+                }
+                while ( ++y != 0 );
+        }
+        while ( ++x != 0 );
+
+        report( 'U' );
+}
+
+/* Expected: Ik */
+void check_inline()
+{
+        uint8_t x = 0;
+
+        do
+        {
+                uint8_t y = 0;
+
+                do
+                {
+                        if ( CDTC_MUL_U8_U8_INLINE( x, y ) != ( uint16_t ) x * y )
+                        {
+                                errors++;
+                        }
+                }
+                while ( ++y != 0 );
+        }
+        while ( ++x != 0 );
+
+        report( 'I' );
+}
+
+/* Every product.  Expected: Sk */
+void check_s8_s8()
+{
+        uint8_t x = 0;
+
+        do
+        {
+                uint8_t y = 0;
+
+                do
+                {
+                        if ( CDTC_MUL_S8_S8( x, y ) != ( int16_t ) ( int8_t ) x * ( int8_t ) y )
+                        {
+                                errors++;
+                        }
+                }
+                while ( ++y != 0 );
+        }
+        while ( ++x != 0 );
+
+        report( 'S' );
+}
+
+/* Every multiplier with 258 multiplicands, multiples of 0xFF from 0
+   to 0xFFFF.  Expected: Mk */
+void check_u16_u8()
+{
+        uint8_t y = 0;
+
+        do
+        {
+                uint16_t x = 0;
+
+                do
+                {
+                        if ( CDTC_MUL_U16_U8( x, y ) != ( uint32_t ) x * y )
+                        {
+                                errors++;
+                        }
+                        x += 0xFF;
+                }
+                while ( x >= 0xFF );
+        }
+        while ( ++y != 0 );
+
+        report( 'M' );
+}
+
+/* Edge cases then 16384 pseudo-random pairs.  Expected: Lk */
+void check_u16_u16()
+{
+        static const uint16_t edges[] = { 0, 1, 0xFF, 0x100, 0x7FFF, 0x8000, 0xFFFE, 0xFFFF };
+        uint16_t x = 1;
+        uint16_t y = 0xACE1;
+        uint16_t i;
+        uint8_t a, b;
+
+        for ( a = 0; a < sizeof( edges ) / sizeof( edges[0] ); a++ )
+        {
+                for ( b = 0; b < sizeof( edges ) / sizeof( edges[0] ); b++ )
+                {
+                        if ( CDTC_MUL_U16_U16( edges[a], edges[b] ) != ( uint32_t ) edges[a] * edges[b] )
+                        {
+                                errors++;
+                        }
+                }
+        }
+
+        for ( i = 0; i < 16384; i++ )
+        {
+                /* xorshift */
+                x ^= x << 7;
+                x ^= x >> 9;
+                x ^= x << 8;
+                y += x ^ 0x5A5A;
+
+                if ( CDTC_MUL_U16_U16( x, y ) != ( uint32_t ) x * y )
+                {
+                        errors++;
+                }
+        }
+
+        report( 'L' );
+}
+
+static void screen_hex16( uint16_t v )
+{
+        fw_txt_output( hexchar( ( v >> 12 ) & 0x0F ) );
+        fw_txt_output( hexchar( ( v >> 8 ) & 0x0F ) );
+        fw_txt_output( hexchar( ( v >> 4 ) & 0x0F ) );
+        fw_txt_output( hexchar( v & 0x0F ) );
+}
+
+static void screen_str( const char *s )
+{
+        while ( *s )
+        {
+                fw_txt_output( *s++ );
+        }
+}
+
+static volatile uint16_t sink16;
+static volatile uint32_t sink32;
+static volatile uint8_t opx = 123;
+static volatile uint8_t opy = 234;
+static volatile uint16_t opx16 = 12345;
+static volatile uint16_t opy16 = 54321;
+
+#define ROUNDS 3000
+
+/* Times ROUNDS products of each kind in 1/300 s, on screen only as
+   they depend on the machine or emulator. */
+#define TIME( label, statement )                                        \
+        do                                                              \
+        {                                                               \
+                uint16_t r;                                             \
+                uint32_t t0 = fw_kl_time_please();                      \
+                for ( r = 0; r < ROUNDS; r++ )                          \
+                {                                                       \
+                        statement;                                      \
+                }                                                       \
+                screen_str( label );                                    \
+                screen_hex16( fw_kl_time_please() - t0 );               \
+                screen_str( "\r\n" );                                   \
+        }                                                               \
+        while ( 0 )
+
+void benchmark()
+{
+        screen_str( "3000 products, 1/300 s\r\n" );
+        TIME( "empty loop     ", sink16 = opx );
+        TIME( "u8  C          ", sink16 = ( uint16_t ) opx * opy );
+        TIME( "u8  cdtc       ", sink16 = CDTC_MUL_U8_U8( opx, opy ) );
+        TIME( "u8  inline     ", sink16 = CDTC_MUL_U8_U8_INLINE( opx, opy ) );
+        TIME( "s8  C          ", sink16 = ( int16_t ) ( int8_t ) opx * ( int8_t ) opy );
+        TIME( "s8  cdtc       ", sink16 = CDTC_MUL_S8_S8( opx, opy ) );
+        TIME( "u16xu8  C      ", sink32 = ( uint32_t ) opx16 * opy );
+        TIME( "u16xu8  cdtc   ", sink32 = CDTC_MUL_U16_U8( opx16, opy ) );
+        TIME( "u16xu16 C      ", sink32 = ( uint32_t ) opx16 * opy16 );
+        TIME( "u16xu16 cdtc   ", sink32 = CDTC_MUL_U16_U16( opx16, opy16 ) );
+}
@@ -0,0 +1,22 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+#include "cdtc/random.h"
+
+void check_lfsr8( void );
+void check_lfsr16( void );
+void check_xorshift16( void );
+void check_table( void );
+
+void
+main()
+{
+        fw_mc_send_printer( '0' );
+
+        check_lfsr8();
+        check_lfsr16();
+        check_xorshift16();
+        check_table();
+
+        fw_mc_send_printer( '1' );
+        fw_mc_wait_flyback();
+}
@@ -0,0 +1,142 @@
+#include "cfwi/cfwi.h"
+#include "cdtc/random.h"
+#include "stdint.h"
+
+#define hexchar(i) ( ( (i) < 10 ) ? ( '0' + (i) ) : ( 'A' - 10 + (i) ) )
+
+static uint16_t errors;
+
+/* Group letter then 'k', or '!' and the error count in hex. */
+static void report( char group )
+{
+        fw_mc_send_printer( group );
+
+        if ( errors == 0 )
+        {
+                fw_mc_send_printer( 'k' );
+                return;
+        }
+
+        fw_mc_send_printer( '!' );
+        fw_mc_send_printer( hexchar( ( errors >> 12 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 8 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( ( errors >> 4 ) & 0x0F ) );
+        fw_mc_send_printer( hexchar( errors & 0x0F ) );
+        errors = 0;
+}
+
+/* Every value but 0 once per period of 255.  Expected: Ek */
+void check_lfsr8()
+{
+        static uint8_t seen[32];
+        uint8_t state = 1;
+        uint16_t i;
+
+        for ( i = 0; i < 255; i++ )
+        {
+                uint8_t v = cdtc_random_lfsr8__fastcall( &state );
+
+                if ( v != state || v == 0 || ( seen[v >> 3] & ( 1 << ( v & 7 ) ) ) )
+                {
+                        errors++;
+                }
+                seen[v >> 3] |= 1 << ( v & 7 );
+        }
+
+        if ( state != 1 )
+        {
+                errors++;
+        }
+
+        report( 'E' );
+}
+
+/* Back to the seed after exactly 65535 steps.  Expected: Fk */
+void check_lfsr16()
+{
+        uint16_t state = 0xACE1;
+        uint16_t i = 0;
+
+        do
+        {
+                i++;
+        }
+        while ( cdtc_random_lfsr16__fastcall( &state ) != 0xACE1 && i != 0 );
+
+        if ( i != 0xFFFF )
+        {
+                errors++;
+        }
+
+        report( 'F' );
+}
+
+/* Back to the seed after exactly 65535 steps.  Expected: Xk */
+void check_xorshift16()
+{
+        uint16_t state = 1;
+        uint16_t i = 0;
+
+        do
+        {
+                i++;
+        }
+        while ( cdtc_random_xorshift16__fastcall( &state ) != 1 && i != 0 );
+
+        if ( i != 0xFFFF || state != 1 )
+        {
+                errors++;
+        }
+
+        report( 'X' );
+}
+
+/* Built-in table works without seeding, seeding replays, table16 is
+   two table8, and values spread evenly.  Expected: Tk */
+void check_table()
+{
+        static uint16_t counts[256];
+        uint16_t first = cdtc_random_table16();
+        uint16_t i;
+        uint8_t a, b;
+
+        if ( cdtc_random_table16() == first && cdtc_random_table16() == first )
+        {
+                errors++;
+        }
+
+        cdtc_random_table_seed( 1 );
+        first = cdtc_random_table16();
+        cdtc_random_table_seed( 1 );
+        if ( cdtc_random_table16() != first )
+        {
+                errors++;
+        }
+
+        cdtc_random_table_seed( 12345 );
+        a = cdtc_random_table8();
+        b = cdtc_random_table8();
+        cdtc_random_table_seed( 12345 );
+        if ( cdtc_random_table16() != ( ( uint16_t ) b << 8 | a ) )
+        {
+                errors++;
+        }
+
+        cdtc_random_table_seed( 12345 );
+        for ( i = 0; i < 25600; i++ )
+        {
+                counts[cdtc_random_table8()]++;
+        }
+
+        i = 0;
+        do
+        {
+                if ( counts[i] < 60 || counts[i] > 140 )
+                {
+                        errors++;
+                }
+        }
+        while ( ++i != 256 );
+
+        report( 'T' );
+}
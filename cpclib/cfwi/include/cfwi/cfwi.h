@@ -27,6 +27,18 @@
    RAM for the Kernel to be able to use them.
 */
 
+#include "cfwi_bare.h"
+#include "cfwi_dbuf.h"
+#include "cfwi_fast_plot.h"
+#include "cfwi_keyboard.h"
+#include "cfwi_palette.h"
+#include "cfwi_psg_player.h"
+#include "cfwi_raster.h"
+#include "cfwi_sched.h"
+#include "cfwi_scr_fill.h"
+#include "cfwi_scr_line_table.h"
+#include "cfwi_sprite.h"
+#include "cfwi_text.h"
 #include "cfwi_txt.h"
 #include "fw_cas.h"
 #include "fw_gra.h"
@@ -0,0 +1,94 @@
+#ifndef  __CFWI_BARE_H__
+#define __CFWI_BARE_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Bare mode: run without the firmware.
+
+   With the firmware active, each of the 300 interrupts per second
+   spends a few hundred NOPs scanning the keyboard, updating sound and
+   processing events.  cfwi_bare_enter() disables both ROMs and puts
+   a minimal handler at the interrupt vector (0x0038): it counts
+   interrupts and frames and calls an optional hook, for about 65 NOPs
+   without a hook.
+
+   In bare mode:
+
+   * no firmware routine may be called, directly (fw_*) or through a
+     cfwi routine using one (cfwi_dbuf, cfwi_palette_step...), and
+     firmware events (cfwi_sched, cfwi_raster) stop.  Use
+     CFWI_BARE_WITH_FIRMWARE for an occasional call.
+   * with a save buffer, 0x0000-0x0037, 0x003B-0x003F (restart
+     vectors) and 0xB900-0xBDFF (Kernel high jumpblock, main
+     jumpblock, indirections) are free for the program.  Entering and
+     leaving exchange them with the save buffer, so program data there
+     survives CFWI_BARE_WITH_FIRMWARE and firmware data survives bare
+     mode.  On the first cfwi_bare_enter() they take the initial
+     content of the buffer.  0xBE00-0xBFFF is left alone: the machine
+     stack is there.  Firmware variables below 0xB900 must not be
+     touched either.
+   * the upper ROM is off, so 0xC000-0xFFFF reads screen memory.
+   * sound is not updated: call fw_sound_reset() before entering.
+   * keyboard state and the firmware time count are not updated.
+   * alternate registers still belong to the firmware, and are put
+     back as they were on leave.
+
+   Typical use:
+
+   static uint8_t save[CFWI_BARE_SAVE_SIZE];
+   cfwi_bare_hook = music_play;
+   cfwi_bare_enter(save);
+   while (!done)
+   {
+       uint8_t frame = cfwi_bare_frames;
+       update_and_draw();
+       while (cfwi_bare_frames == frame);
+   }
+   cfwi_bare_leave();
+*/
+
+/** Size of the buffer saving the areas freed in bare mode. */
+#define CFWI_BARE_SAVE_SIZE (0x40 + 0x500)
+
+typedef void (*cfwi_bare_hook_t)(void);
+
+/** Called from the interrupt handler when not NULL, with interrupts
+    disabled.  It must return within about 3000 NOPs, before the next
+    interrupt. */
+extern cfwi_bare_hook_t cfwi_bare_hook;
+
+/** Incremented at each interrupt, 300 times per second. */
+extern volatile uint16_t cfwi_bare_ticks;
+
+/** Incremented at each frame flyback. */
+extern volatile uint8_t cfwi_bare_frames;
+
+/** Enter bare mode.  save_buffer, if not NULL, holds
+    CFWI_BARE_SAVE_SIZE bytes and makes low memory and the jumpblocks
+    free for use, see above.  The buffer must not be used by the
+    program in bare mode: it holds the firmware data.  Does nothing if already in bare mode.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_bare_enter(uint8_t *save_buffer) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Give the machine back to the firmware as it was before
+    cfwi_bare_enter().  Returns the save_buffer given to it, so that
+    bare mode can be entered again the same way, or NULL if not in bare
+    mode.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+uint8_t *cfwi_bare_leave(void) __preserves_regs(iyh, iyl);
+
+/** From bare mode, run statement with the firmware back, e.g.
+    CFWI_BARE_WITH_FIRMWARE(fw_txt_output('A'));
+    Costs two exchanges of the save buffer, if any, about 1.1 frames
+    each. */
+#define CFWI_BARE_WITH_FIRMWARE(statement) \
+	do { uint8_t *cfwi_bare_save_buffer_ = cfwi_bare_leave(); statement; cfwi_bare_enter(cfwi_bare_save_buffer_); } while (0)
+
+#endif /* __CFWI_BARE_H__ */
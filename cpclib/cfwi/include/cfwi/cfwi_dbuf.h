@@ -0,0 +1,74 @@
+#ifndef  __CFWI_DBUF_H__
+#define __CFWI_DBUF_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Double-buffered rendering.
+
+   Two 16K banks hold a screen each: the visible one is displayed
+   while the next frame is drawn into the hidden one, then
+   cfwi_dbuf_flip swaps them during frame flyback, so that a frame is
+   never seen half drawn.
+
+   The usual pair is 0xC0 (the default screen) and 0x40.  The 0x4000
+   bank then overlaps program and data memory, make sure to link them
+   elsewhere.
+
+   Everything that draws is pointed at the hidden bank:
+
+   * firmware text and graphics VDUs, through SCR SET BASE, so that
+     their view of the screen stays consistent,
+   * cfwi_fast_plot_* routines, through cfwi_fast_plot_line_table,
+   * sprites and fills take screen addresses: compute them from
+     cfwi_dbuf_hidden_line_table.
+
+   Hardware scroll offset is taken from the firmware at init and kept
+   as is.  Avoid operations that make the firmware send its own base
+   to the hardware (text scrolling the whole screen, SCR SET OFFSET),
+   they would display the hidden bank.
+
+   Typical use:
+
+   cfwi_dbuf_init(0x40, table_a, table_b);
+   cfwi_fast_plot_setup(1, cfwi_dbuf_hidden_line_table);
+   for (;;)
+   {
+       cfwi_scr_fill(cfwi_dbuf_hidden_msb, 0);
+       draw_everything();
+       cfwi_dbuf_flip();
+   }
+*/
+
+/** Most significant byte of the bank being displayed. */
+extern uint8_t cfwi_dbuf_visible_msb;
+
+/** Most significant byte of the bank being drawn. */
+extern uint8_t cfwi_dbuf_hidden_msb;
+
+/** Line address table of the bank being displayed. */
+extern uint8_t **cfwi_dbuf_visible_line_table;
+
+/** Line address table of the bank being drawn. */
+extern uint8_t **cfwi_dbuf_hidden_line_table;
+
+/** Start double buffering.  The current firmware screen becomes the
+    visible bank, hidden_msb the hidden one.  Fills two line tables of
+    CFWI_SCR_LINE_TABLE_LINES entries each, one per bank (e.g. one of
+    them can be cfwi_scr_line_table), and points drawing at the
+    hidden bank.  Does not clear any bank.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_dbuf_init(uint8_t hidden_msb, uint8_t **visible_table, uint8_t **hidden_table) __preserves_regs(iyh, iyl);
+
+/** Wait for frame flyback, then display the bank that was hidden and
+    point drawing at the other one.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_dbuf_flip(void) __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_DBUF_H__ */
@@ -0,0 +1,72 @@
+#ifndef  __CFWI_FAST_PLOT_H__
+#define __CFWI_FAST_PLOT_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Firmware-free pixel plotting.
+
+   fw_gra_plot_absolute goes through the firmware jump block, origin
+   transform, graphics window clipping and SCR DOT POSITION, which
+   costs hundreds of NOPs per pixel.  These routines write screen
+   memory directly.
+
+   Coordinates are screen pixels of the current mode, origin at the
+   top left, y growing downwards.  The address of each line is taken
+   from a line table (see cfwi_scr_line_table.h), the bits of each
+   pixel from a per-mode mask table.
+
+   Cost of a pixel in mode 1, from C, is about 100 NOPs including call
+   overhead, counted from instructions.  Clipped variants add about 20
+   NOPs.  The fast_plot_benchmark test compares them with
+   fw_gra_plot_absolute and prints the speed ratio when run.
+
+   WARNING DONE BUT UNTESTED, MIGHT NOT WORK: fast_plot_benchmark has
+   not been run on an emulator yet, so no ratio has been measured and
+   its reference output is the expected one, not a recorded run.
+
+   Typical use:
+
+   cfwi_scr_line_table_fill(cfwi_scr_line_table, (uint8_t *)0xC000, 40, CFWI_SCR_LINE_TABLE_LINES);
+   cfwi_fast_plot_setup(1, cfwi_scr_line_table);
+   cfwi_fast_plot_set_pen(3);
+   cfwi_fast_plot_set(x, y);
+*/
+
+/** Line table used by the plot routines.  Set by
+    cfwi_fast_plot_setup, can be changed at any time, for example to
+    draw to another screen bank. */
+extern uint8_t **cfwi_fast_plot_line_table;
+
+/** Byte with all pixels in the current pen.  Set by
+    cfwi_fast_plot_set_pen. */
+extern uint8_t cfwi_fast_plot_pen_byte;
+
+/** Must be called before plotting and after a mode change.  Sets
+    screen mode (0, 1 or 2) used to compute pixel addresses, line
+    table, clipping to a standard screen (160 << mode pixels, 200 lines)
+    and pen 1. */
+void cfwi_fast_plot_setup(uint8_t mode, uint8_t **line_table) __preserves_regs(iyh, iyl);
+
+/** Set pen for cfwi_fast_plot_set and cfwi_fast_plot_xor. */
+void cfwi_fast_plot_set_pen(uint8_t pen) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Set clipping rectangle of *_clipped variants, from (0,0) to
+    (width-1,height-1), for screens of non-standard size. */
+void cfwi_fast_plot_set_clip(uint16_t width, uint8_t height) __preserves_regs(b, c, iyh, iyl);
+
+/** Plot a pixel with the current pen. */
+void cfwi_fast_plot_set(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+void cfwi_fast_plot_set_clipped(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+
+/** Plot a pixel with pen 0. */
+void cfwi_fast_plot_reset(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+void cfwi_fast_plot_reset_clipped(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+
+/** Exclusive-or a pixel with the current pen. */
+void cfwi_fast_plot_xor(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+void cfwi_fast_plot_xor_clipped(uint16_t x, uint8_t y) __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_FAST_PLOT_H__ */
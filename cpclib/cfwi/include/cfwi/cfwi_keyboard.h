@@ -0,0 +1,139 @@
+#ifndef  __CFWI_KEYBOARD_H__
+#define __CFWI_KEYBOARD_H__
+
+#include <stdint.h>
+
+#include "fw_km.h"
+
+/**
+   #### CFWI-specific information: ####
+
+   Direct keyboard scan.
+
+   fw_km_test_key tests one key at a time through the firmware, from a
+   state map the firmware updates in its own interrupt.
+   cfwi_keyboard_scan reads the 10 lines of the keyboard matrix
+   straight from the PSG through the PPI, in about 210 NOPs with the
+   call, into cfwi_keyboard_matrix.  Keys are then tested with
+   CFWI_KEY_PRESSED, which compiles to a load and a bit test for a
+   constant key.
+
+   It works in bare mode too (cfwi_bare.h).  It disables interrupts
+   while scanning, and enables them again only if they were enabled.
+
+   No debouncing, no ghosting filter: what the hardware says.  It
+   relies on PSG port A being an input (bit 6 of PSG register 7
+   clear), as the firmware sets it; a direct PSG music player must
+   keep it so.
+
+   Typical use, once per frame:
+
+   cfwi_keyboard_scan();
+   if (CFWI_KEY_PRESSED(cfwi_key_space)) fire();
+   joy = CFWI_KEYBOARD_JOYSTICK_0;
+   if (joy & fw_joystick_mask_left) go_left();
+*/
+
+/** Hardware key numbers, as used by the firmware: line * 8 + bit. */
+enum cfwi_key
+{
+	cfwi_key_cursor_up = 0,
+	cfwi_key_cursor_right = 1,
+	cfwi_key_cursor_down = 2,
+	cfwi_key_f9 = 3,
+	cfwi_key_f6 = 4,
+	cfwi_key_f3 = 5,
+	cfwi_key_enter = 6,
+	cfwi_key_f_dot = 7,
+	cfwi_key_cursor_left = 8,
+	cfwi_key_copy = 9,
+	cfwi_key_f7 = 10,
+	cfwi_key_f8 = 11,
+	cfwi_key_f5 = 12,
+	cfwi_key_f1 = 13,
+	cfwi_key_f2 = 14,
+	cfwi_key_f0 = 15,
+	cfwi_key_clr = 16,
+	cfwi_key_open_bracket = 17,
+	cfwi_key_return = 18,
+	cfwi_key_close_bracket = 19,
+	cfwi_key_f4 = 20,
+	cfwi_key_shift = 21,
+	cfwi_key_backslash = 22,
+	cfwi_key_control = 23,
+	cfwi_key_caret = 24,
+	cfwi_key_minus = 25,
+	cfwi_key_at = 26,
+	cfwi_key_p = 27,
+	cfwi_key_semicolon = 28,
+	cfwi_key_colon = 29,
+	cfwi_key_slash = 30,
+	cfwi_key_dot = 31,
+	cfwi_key_0 = 32,
+	cfwi_key_9 = 33,
+	cfwi_key_o = 34,
+	cfwi_key_i = 35,
+	cfwi_key_l = 36,
+	cfwi_key_k = 37,
+	cfwi_key_m = 38,
+	cfwi_key_comma = 39,
+	cfwi_key_8 = 40,
+	cfwi_key_7 = 41,
+	cfwi_key_u = 42,
+	cfwi_key_y = 43,
+	cfwi_key_h = 44,
+	cfwi_key_j = 45,
+	cfwi_key_n = 46,
+	cfwi_key_space = 47,
+	cfwi_key_6 = 48,
+	cfwi_key_5 = 49,
+	cfwi_key_r = 50,
+	cfwi_key_t = 51,
+	cfwi_key_g = 52,
+	cfwi_key_f = 53,
+	cfwi_key_b = 54,
+	cfwi_key_v = 55,
+	cfwi_key_4 = 56,
+	cfwi_key_3 = 57,
+	cfwi_key_e = 58,
+	cfwi_key_w = 59,
+	cfwi_key_s = 60,
+	cfwi_key_d = 61,
+	cfwi_key_c = 62,
+	cfwi_key_x = 63,
+	cfwi_key_1 = 64,
+	cfwi_key_2 = 65,
+	cfwi_key_esc = 66,
+	cfwi_key_q = 67,
+	cfwi_key_tab = 68,
+	cfwi_key_a = 69,
+	cfwi_key_caps_lock = 70,
+	cfwi_key_z = 71,
+	cfwi_key_joystick_0_up = 72,
+	cfwi_key_joystick_0_down = 73,
+	cfwi_key_joystick_0_left = 74,
+	cfwi_key_joystick_0_right = 75,
+	cfwi_key_joystick_0_fire_2 = 76,
+	cfwi_key_joystick_0_fire_1 = 77,
+	cfwi_key_joystick_0_spare = 78,
+	cfwi_key_del = 79,
+};
+
+/** One byte per matrix line, one bit per key, 0 when pressed. */
+extern uint8_t cfwi_keyboard_matrix[10];
+
+/** Read the whole keyboard matrix into cfwi_keyboard_matrix.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_keyboard_scan(void) __preserves_regs(d, e, iyh, iyl);
+
+/** True if key (enum cfwi_key) was pressed at the last scan. */
+#define CFWI_KEY_PRESSED(key) ((cfwi_keyboard_matrix[(key) >> 3] & (1 << ((key) & 7))) == 0)
+
+/** Joystick states at the last scan, as fw_joystick_mask_* bits.
+    Joystick 1 shares its matrix line with keys 6 5 R T G F B. */
+#define CFWI_KEYBOARD_JOYSTICK_0 ((uint8_t) ~cfwi_keyboard_matrix[9] & 0x7F)
+#define CFWI_KEYBOARD_JOYSTICK_1 ((uint8_t) ~cfwi_keyboard_matrix[6] & 0x7F)
+
+#endif /* __CFWI_KEYBOARD_H__ */
@@ -0,0 +1,71 @@
+#ifndef  __CFWI_PALETTE_H__
+#define __CFWI_PALETTE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fw_mc.h"
+
+/**
+   #### CFWI-specific information: ####
+
+   Palette fades and colour cycling.
+
+   Calling fw_scr_set_ink for each pen at each step of a fade goes
+   through the Screen Pack, and each change only shows at the next
+   frame flyback.  Instead, a ramp of full palettes (ink_vector16, 17
+   bytes each) is computed once, then played one palette per frame with
+   MC SET INKS.  Playing costs about 40 NOPs per frame on top of MC SET
+   INKS, whatever the number of inks changing.
+
+   Fades and cycles are both ramps: a fade played once, a cycle played
+   in a loop.
+
+   Since MC SET INKS bypasses the Screen Pack, the Screen Pack will set
+   its own inks again at the next flash or ink change.  Disable its ink
+   handling first, e.g. with fw_kl_choke_off, see fw_mc_set_inks__16.
+
+   Typical use:
+
+   static ink_vector16 ramp[16];
+   cfwi_palette_fade_build(ramp, &game_palette, &all_black, 16);
+   cfwi_palette_play(ramp, 16, false);
+   do
+   {
+       fw_mc_wait_flyback();
+   }
+   while (cfwi_palette_step());
+*/
+
+/** Fill ramp with steps palettes (1 to 64), from "from" to "to"
+    included.  Each red, green and blue level is interpolated
+    separately, with rounding.  Border is faded too.  ramp must hold
+    steps ink_vector16.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_palette_fade_build(ink_vector16 *ramp, const ink_vector16 *from, const ink_vector16 *to, uint8_t steps) __preserves_regs(iyh, iyl);
+
+/** Fill ramp with last_ink - first_ink + 1 copies of base, where inks
+    first_ink to last_ink are rotated by one more position in each
+    copy.  Played in a loop, colours cycle through these inks.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_palette_cycle_build(ink_vector16 *ramp, const ink_vector16 *base, uint8_t first_ink, uint8_t last_ink) __preserves_regs(iyh, iyl);
+
+/** Start playing count palettes from ramp, forever if loop is true.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_palette_play(const ink_vector16 *ramp, uint8_t count, bool loop) __preserves_regs(iyh, iyl);
+
+/** Set the next palette of the ramp, to be called once per frame.
+    Returns false, without setting anything, once a ramp that does not
+    loop is over.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+bool cfwi_palette_step(void) __preserves_regs(b, c, iyh, iyl);
+
+#endif /* __CFWI_PALETTE_H__ */
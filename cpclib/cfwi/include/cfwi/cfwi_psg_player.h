@@ -0,0 +1,102 @@
+#ifndef  __CFWI_PSG_PLAYER_H__
+#define __CFWI_PSG_PLAYER_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Music and sound effects played by writing precomputed AY register
+   values straight to the PSG through the PPI, once per frame.
+
+   Unlike the firmware sound queues, nothing is computed at run time:
+   a stream holds, for each frame, which of registers 0 to 13 change
+   and their new values, and only those are written.  The cost of a
+   frame is therefore small and known in advance: about 70 NOPs per
+   changed register plus about 100 NOPs, so at most about 1100 NOPs
+   when all 14 registers change, and about 80 NOPs on frames where
+   nothing changes.
+
+   Streams are generated on the host by tool/ym2cpcpsg from YM files
+   or raw register dumps.  The cpc-dev-tool-chain Makefile does this
+   for you: foo.ym in your project gives foo.generated.s which
+   exports psg_foo_data, and a sound effect foo.effect.ym gives a
+   stream that does not loop and exports psg_foo_effect_data, see
+   tool/ym2cpcpsg/README.md.
+
+   Stream format, for reference:
+   - 2 bytes: offset of the loop frame from the first frame, 0xFFFF
+     if the stream does not loop,
+   - 2 bytes: registers written anywhere in the stream, bit n for
+     register n,
+   - frames, each starting with 2 bytes of register mask, bit n for
+     register n, followed by the values of registers in the mask, in
+     register order.  A mask with bit 14 set is instead a count, in
+     its low byte, of frames where nothing changes.  A mask with bit
+     15 set ends the stream: playing goes on at the loop frame, or
+     stops.
+
+   A sound effect is a stream that temporarily takes over the
+   registers it writes: while it plays, music keeps running but only
+   updates its own copy of those registers, and they are written back
+   when the effect ends.  Register 7 (mixer) is shared by all
+   channels, so an effect that writes it decides for the music too.
+   Register 13 (envelope shape) is not written back since writing it
+   restarts the envelope.
+
+   Register 7 bit 6 is kept clear by the converter, so that the
+   keyboard scan (firmware or cfwi_keyboard_scan) still works.  Do not
+   use the firmware sound queues at the same time, call fw_sound_reset
+   once first.
+
+   Typical use:
+
+   extern const uint8_t psg_song_data[];
+   extern const uint8_t psg_bang_data[];
+
+   cfwi_psg_player_start(psg_song_data);
+   while (1)
+   {
+           fw_mc_wait_flyback();
+           cfwi_psg_player_frame();
+           ...
+           if (shot) cfwi_psg_player_effect(psg_bang_effect_data);
+   }
+
+   cfwi_psg_player_frame can also be called from a frame flyback
+   event, see cfwi_sched_every_frame, cfwi_psg_player_effect must then
+   be called from the same event or with interrupts disabled.
+*/
+
+/** Start playing a music stream from its first frame.  This also
+    stops any sound effect.  The stream must stay in memory while it
+    plays.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_psg_player_start(const uint8_t *stream) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Start playing a sound effect stream over the music, from the next
+    call to cfwi_psg_player_frame.  A sound effect still playing is
+    replaced.  Only valid after cfwi_psg_player_start.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_psg_player_effect(const uint8_t *stream) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Play one frame of music and sound effect.  Call once per frame
+    (50 times per second), for example just after frame flyback.
+    Preserves the interrupt state.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_psg_player_frame(void) __preserves_regs(iyh, iyl);
+
+/** Stop music and sound effect and silence the PSG.  Does not
+    change the interrupt state.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_psg_player_stop(void) __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_PSG_PLAYER_H__ */
@@ -0,0 +1,70 @@
+#ifndef  __CFWI_RASTER_H__
+#define __CFWI_RASTER_H__
+
+#include <stdint.h>
+
+#include "fw_mc.h"
+
+/**
+   #### CFWI-specific information: ####
+
+   Raster palette splits: different inks in up to 6 horizontal zones
+   of the screen, at no cost per pixel.
+
+   The Gate Array interrupts the CPU 6 times per frame, every 52 scan
+   lines, the first one 2 lines after frame flyback starts.  An express
+   fast ticker event runs at each interrupt and writes the inks of the
+   zone that starts there directly to the Gate Array.  Zone 0 is the
+   one that starts with frame flyback, which resynchronizes the zone
+   count every frame.
+
+   With the default CRTC settings, zones start at these lines of the
+   200-line screen (lines past 199 are bottom border, then top
+   border):
+
+   zone   0    1    2    3    4    5
+   line  242  294   34   86  138  190
+
+   so the screen shows zone 1 inks at the top, then zones 2 to 5.
+   Changes happen once the firmware reaches the event, always at the same
+   place, and take 17 NOPs per pen: a zone changing all 16 inks and
+   the border spreads the change over about 5 lines.  Interrupts that
+   start no zone cost about 30 NOPs.
+
+   The Screen Pack also sets inks when it flashes them; disable it
+   first with fw_kl_choke_off, see fw_mc_set_inks__16.
+
+   Typical use:
+
+   static const ink_vector16 zones[6] = { ... };
+   fw_kl_choke_off__ignore_return_value();
+   cfwi_raster_start(zones, 6, 0, 4);   // pens 0 to 3 change per zone
+*/
+
+/** Gate Array pen number of the border. */
+#define CFWI_RASTER_BORDER 16
+
+/** Start splits.  zones holds zone_count palettes (1 to 6), zone
+    number 0 first.  In each zone, Gate Array pens first_pen to
+    first_pen + pen_count - 1 are set (pen 16 is the border, so 0, 17
+    sets all inks and the border).  Zones past zone_count are left as
+    the previous zone set them.  zones is converted to Gate Array
+    values and needs not be kept.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_raster_start(const ink_vector16 *zones, uint8_t zone_count, uint8_t first_pen, uint8_t pen_count) __preserves_regs(iyh, iyl);
+
+/** Change the palette of one zone, taking effect at its next start.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_raster_set_zone(uint8_t zone, const ink_vector16 *inks) __preserves_regs(iyh, iyl);
+
+/** Stop splits.  Inks stay as the last zone set them.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_raster_stop(void) __preserves_regs(b, c, iyh, iyl);
+
+#endif /* __CFWI_RASTER_H__ */
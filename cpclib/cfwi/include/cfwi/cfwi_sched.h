@@ -0,0 +1,95 @@
+#ifndef  __CFWI_SCHED_H__
+#define __CFWI_SCHED_H__
+
+#include <stdint.h>
+
+#include "fw_kl.h"
+
+/**
+   #### CFWI-specific information: ####
+
+   Run C functions from firmware events instead of busy-waiting on
+   fw_mc_wait_flyback: at each frame flyback (50 Hz), at each fast
+   ticker interrupt (300 Hz) or every N ticks (every N frames).
+
+   Each registration uses a slot provided by the caller, which holds
+   the firmware block and a tiny trampoline generated at registration:
+
+       push iy / call callback / pop iy / ret
+
+   SDCC code may change IY, which the interrupted program may be
+   using; the trampoline keeps it.  AF, BC, DE and HL are the
+   firmware's business, IX is preserved by SDCC code itself.  The
+   trampoline adds 16 NOPs to each call.
+
+   Events are asynchronous, near address: callbacks run at interrupt
+   time, just before the firmware returns from the interrupt, with
+   interrupts enabled.  Hence:
+
+   * a callback must finish before the next one of its kind is due
+     (1/300 s is about 3300 NOPs, shared with the firmware),
+   * variables it shares with the main program should be volatile,
+   * it must not call firmware routines that wait (keyboard, cassette,
+     MC WAIT FLYBACK), nor use the alternate registers.
+
+   Slots, callbacks and the data they use must lie in the central 32K
+   of RAM (0x4000-0xBFFF), like all Kernel blocks.
+
+   Typical use:
+
+   static cfwi_sched_slot_t music_slot;
+   static volatile uint8_t frame_count;
+
+   void on_frame(void) { frame_count++; music_play(); }
+
+   cfwi_sched_every_frame(&music_slot, on_frame);
+   ...
+   cfwi_sched_cancel(&music_slot);
+*/
+
+typedef void (*cfwi_sched_callback_t)(void);
+
+/** Storage for one registration.  Contents are private, only its
+    address matters.  Do not touch or reuse a registered slot before
+    cfwi_sched_cancel. */
+typedef struct cfwi_sched_slot_t
+{
+	union
+	{
+		fw_kl_frame_flyback_block_t frame_flyback;
+		fw_kl_fast_ticker_block_t fast_ticker;
+		fw_kl_ticker_block_t ticker;
+	} block;
+	uint8_t kind;
+	uint8_t trampoline[8];
+} cfwi_sched_slot_t;
+
+/** Call callback at each frame flyback, in sync with the display.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sched_every_frame(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback) __preserves_regs(iyh, iyl);
+
+/** Call callback at each fast ticker interrupt, 300 times per second.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sched_fast(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback) __preserves_regs(iyh, iyl);
+
+/** Call callback every frame_count ticks of 1/50 s, first time
+    frame_count ticks from now.  frame_count must not be 0.  Ticks
+    are not synchronized with frame flyback.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sched_every_n_frames(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback, uint16_t frame_count) __preserves_regs(iyh, iyl);
+
+/** Stop calling the callback registered with slot.  slot must have
+    been registered.  A call already pending in the current interrupt
+    may still happen once.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sched_cancel(cfwi_sched_slot_t *slot) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+#endif /* __CFWI_SCHED_H__ */
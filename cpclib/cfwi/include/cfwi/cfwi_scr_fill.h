@@ -0,0 +1,41 @@
+#ifndef  __CFWI_SCR_FILL_H__
+#define __CFWI_SCR_FILL_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Fast screen clear and rectangle fill.
+
+   Both write screen memory with PUSH of a register pair holding the
+   fill byte twice, 2 NOPs per byte, with SP pointing into screen
+   memory while interrupts are disabled.  They never keep interrupts
+   disabled long enough to lose one.
+
+   For comparison, a `ld (hl),a / inc hl` loop costs 8 NOPs per byte,
+   LDIR 6.  A whole 16K bank cannot be filled within one frame (19968
+   NOPs) even with PUSH; cfwi_scr_fill takes about 1.8 frames.  Fill a
+   bank that is not displayed to avoid showing a half-cleared screen.
+
+   Both routines must not be called from an interrupt handler.
+*/
+
+/** Fill the whole 16K bank starting at bank_msb * 256 (e.g. 0xC0)
+    with byte.  About 35000 NOPs.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_scr_fill(uint8_t bank_msb, uint8_t byte) __preserves_regs(iyh, iyl);
+void cfwi_scr_fill__fastcall(uint16_t bank_msb8h_byte8l) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Fill a rectangle of width bytes (at most 80) by height lines, whose
+    top left byte is at top_left in screen memory, following screen
+    interleave.  Screen lines are assumed 80 bytes wide (CRTC R1 = 40).
+    2 NOPs per byte plus about 30 per line.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_scr_fill_rect(uint8_t *top_left, uint8_t width, uint8_t height, uint8_t byte) __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_SCR_FILL_H__ */
@@ -0,0 +1,80 @@
+#ifndef  __CFWI_SCR_LINE_TABLE_H__
+#define __CFWI_SCR_LINE_TABLE_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Screen line address tables.
+
+   CPC screen memory is interleaved: line y starts at
+
+   first_line + (y % 8) * 0x800 + (y / 8) * 2 * R1
+
+   where R1 is the CRTC horizontal displayed register (40 by default,
+   so 80 bytes per character row).  Computing this per pixel is slow.
+   Fast renderers instead look line addresses up in a table built once
+   (and again after changing screen base, offset or R1).
+
+   first_line is the address of the top left byte of the screen, for
+   example 0xC000 for the default screen, or screen base plus offset
+   after hardware scrolling.  It must be in the first 0x800 bytes of the
+   16K screen bank, which is always the case with firmware settings.
+   Line addresses do not wrap at 0x800 boundaries like the hardware
+   does, so with an offset, lines of the last character rows may be
+   wrong.
+
+   Two table layouts are offered.
+
+   Linear table: an array of line_count pointers.  Lookup is an
+   indexed array access.  Filled with PUSH, which is fastest.
+
+   Split table: low bytes of line addresses in a 256-byte page, high
+   bytes in the following page.  From assembly, lookup is:
+
+        ld      h,#table_page
+        ld      l,a             ; a = line number
+        ld      e,(hl)
+        inc     h
+        ld      d,(hl)          ; de = line address
+
+   This costs 7 NOPs, without any 16-bit index arithmetic.
+*/
+
+/** Number of lines of a standard screen, size of cfwi_scr_line_table. */
+#define CFWI_SCR_LINE_TABLE_LINES 200
+
+/** Ready to use storage for a linear table of a standard screen.
+    Fill it with for example:
+    cfwi_scr_line_table_fill(cfwi_scr_line_table, (uint8_t *)0xC000, 40, CFWI_SCR_LINE_TABLE_LINES);
+*/
+extern uint8_t *cfwi_scr_line_table[CFWI_SCR_LINE_TABLE_LINES];
+
+/** Fill a linear table with line_count entries.
+
+    17 NOPs per line, about 3.5 ms for 200 lines.  Interrupts are
+    disabled during the fill, and enabled on return.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_scr_line_table_fill(uint8_t **table, uint8_t *first_line, uint8_t crtc_r1, uint8_t line_count) __preserves_regs(iyh, iyl);
+
+/** Fill a split table: low bytes at address table_page * 256, high
+    bytes at (table_page + 1) * 256.  line_count is at most 255 (0 fills nothing).
+
+    20 NOPs per line, about 4 ms for 200 lines.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_scr_line_table_split_fill(uint8_t table_page, uint8_t *first_line, uint8_t crtc_r1, uint8_t line_count) __preserves_regs(iyh, iyl);
+
+/** Address of line y in a linear table. */
+#define CFWI_SCR_LINE_ADDRESS(table, y) ((table)[(y)])
+
+/** Address of line y in a split table. */
+#define CFWI_SCR_LINE_SPLIT_ADDRESS(table_page, y)                      \
+        ((uint8_t *)(((const uint8_t *)((uint16_t)(table_page) << 8))[(uint8_t)(y)] \
+                     | ((uint16_t)((const uint8_t *)((uint16_t)((table_page) + 1) << 8))[(uint8_t)(y)] << 8)))
+
+#endif /* __CFWI_SCR_LINE_TABLE_H__ */
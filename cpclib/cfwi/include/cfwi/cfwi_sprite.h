@@ -0,0 +1,96 @@
+#ifndef  __CFWI_SPRITE_H__
+#define __CFWI_SPRITE_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Sprite blitters for data generated by png2cpcsprite.
+
+   A sprite is described by its data address and size, in the same
+   order as png2cpcsprite symbols.  With symbols generated for C,
+   e.g. --symbol_format_string=_sprite_%s, and the generated
+   *.generated_from_asm_exported_symbols.h header included:
+
+   extern const uint8_t sprite_ship_data[];
+   const cfwi_sprite_t ship = CFWI_SPRITE(sprite_ship);
+
+   Blitters take the sprite in HL (fastcall) and draw at
+   cfwi_sprite_screen, the address of the top left byte in screen
+   memory, for example from cfwi_scr_line_table.  Setting it is a
+   plain store, no call.  Screen lines are 80 bytes wide (CRTC R1 =
+   40) and the destination may cross character rows.  Sprites are at
+   most 80 bytes wide.
+
+   Each blitter enters an unrolled loop at the point that matches the
+   sprite width, so there is no per-byte loop overhead.  Costs, in
+   NOPs (microseconds):
+
+   | routine                | per byte | per line | per call |
+   |------------------------|----------|----------|----------|
+   | cfwi_sprite_opaque     |        5 |       21 |     ~100 |
+   | cfwi_sprite_save_under |        5 |       21 |     ~100 |
+   | cfwi_sprite_restore    |        5 |       21 |     ~100 |
+   | cfwi_sprite_xor        |       10 |       22 |      ~60 |
+   | cfwi_sprite_masked     |       14 |       22 |      ~60 |
+
+   Add 9 per character row crossed (every 8 lines).  For example a
+   8 bytes by 16 lines sprite (16x16 pixels in mode 0) takes about
+   1100 NOPs opaque and 2200 masked, out of 19968 per frame.
+
+   From assembly, entries named like cfwi_sprite_opaque_hl_de take the
+   sprite in HL and the screen address in DE.
+*/
+
+typedef struct cfwi_sprite_s
+{
+        const uint8_t *data;
+        uint8_t bytes_per_line;
+        uint8_t height;
+} cfwi_sprite_t;
+
+/** Initializer of a cfwi_sprite_t from png2cpcsprite symbols whose C
+    name starts with SYMBOL. */
+#define CFWI_SPRITE(SYMBOL) { SYMBOL ## _data, ASMCONST__ ## SYMBOL ## _bytes_per_line, ASMCONST__ ## SYMBOL ## _height }
+
+/** Screen address where the next blit happens. */
+extern uint8_t *cfwi_sprite_screen;
+
+/** Buffer for cfwi_sprite_save_under and cfwi_sprite_restore, of
+    bytes_per_line * height bytes. */
+extern uint8_t *cfwi_sprite_buffer;
+
+/** Copy sprite data to screen.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sprite_opaque(const cfwi_sprite_t *sprite) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Copy screen area that sprite would cover to cfwi_sprite_buffer.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sprite_save_under(const cfwi_sprite_t *sprite) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Copy cfwi_sprite_buffer back to screen, only using sprite size.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sprite_restore(const cfwi_sprite_t *sprite) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Exclusive-or sprite data onto screen.  Drawing twice restores.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sprite_xor(const cfwi_sprite_t *sprite) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Draw a sprite whose data interleaves, for each screen byte, a mask
+    byte then a data byte: screen = (screen AND mask) OR data.
+    bytes_per_line counts screen bytes, that is pairs.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_sprite_masked(const cfwi_sprite_t *sprite) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_SPRITE_H__ */
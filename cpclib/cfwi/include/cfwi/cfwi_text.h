@@ -0,0 +1,66 @@
+#ifndef  __CFWI_TEXT_H__
+#define __CFWI_TEXT_H__
+
+#include <stdint.h>
+
+/**
+   #### CFWI-specific information: ####
+
+   Direct text renderer with a cached expanded font.
+
+   cfwi_txt_str0_output and fw_txt_output go through TXT OUTPUT for
+   each character: control codes, cursor, window, and expansion of
+   the character matrix pixel by pixel.  For a HUD redrawn every frame
+   this is far too slow.
+
+   Here the font is read once with TXT GET MATRIX (so user defined
+   matrices are honored) and expanded into screen bytes for one mode,
+   pen and paper.  Drawing a character is then a copy of 8 rows to
+   screen memory, 8 lines apart.  Per character, in NOPs: about 340 in
+   mode 0, 260 in mode 1, 220 in mode 2.
+
+   Characters are drawn at cfwi_text_screen, which must be the address
+   of the top line of a character row (e.g. 0xC000 + row * 80 + column
+   * bytes per character for a standard screen), and is advanced past
+   each character drawn.  Setting it is a plain store, no call.  There
+   is no control code, no wrap and no scroll.
+
+   The expanded font takes 32 bytes per character in mode 0, 16 in mode
+   1, 8 in mode 2: 96 characters from ' ' take 1536 bytes in mode 1.
+
+   Typical use:
+
+   static uint8_t font[96 * 16];
+   cfwi_text_setup(font, 1, 3, 0, ' ', 96);
+   ...
+   cfwi_text_screen = (uint8_t *)0xC000 + 24 * 80;
+   cfwi_text_draw_str0("SCORE 00120");
+*/
+
+/** Screen address of the next character to draw. */
+extern uint8_t *cfwi_text_screen;
+
+/** Expand char_count characters starting at first_char into
+    font_buffer, for mode with pen and paper.  Must be called again
+    after a mode, pen or paper change or a matrix redefinition.
+    This routine enables the lower ROM to read the font, so it must not
+    be linked below 0x4000.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_text_setup(uint8_t *font_buffer, uint8_t mode, uint8_t pen, uint8_t paper, uint8_t first_char, uint8_t char_count) __preserves_regs(iyh, iyl);
+
+/** Draw a NUL terminated string at cfwi_text_screen.  Characters
+    outside the expanded range are skipped, leaving a gap.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_text_draw_str0(const char *s) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+/** Draw one character at cfwi_text_screen.
+
+    WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+*/
+void cfwi_text_draw_char(char c) __z88dk_fastcall __preserves_regs(iyh, iyl);
+
+#endif /* __CFWI_TEXT_H__ */
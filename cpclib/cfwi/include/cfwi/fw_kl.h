@@ -133,6 +133,304 @@ uint32_t fw_kl_rom_walk(uint32_t fw_memory_range_t_asint) __z88dk_fastcall __pre
 
 // void fw_kl_scan_needed(void);
 
+/** Event block, see Soft968 section 12.  Must lie in the central 32K
+    of RAM.  The user field, if any, follows immediately. */
+typedef struct fw_kl_event_block_t
+{
+	void *chain;
+	uint8_t count;
+	uint8_t event_class;
+	void *routine;
+	uint8_t rom_select;
+} fw_kl_event_block_t;
+
+/** Bits of the event class byte, see KL INIT EVENT. */
+#define FW_KL_EVENT_CLASS_NEAR_ADDRESS 0x01
+#define FW_KL_EVENT_CLASS_PRIORITY(priority) ((priority) << 1)
+#define FW_KL_EVENT_CLASS_EXPRESS 0x40
+#define FW_KL_EVENT_CLASS_ASYNCHRONOUS 0x80
+
+typedef struct fw_kl_frame_flyback_block_t
+{
+	void *chain;
+	fw_kl_event_block_t event;
+} fw_kl_frame_flyback_block_t;
+
+typedef struct fw_kl_fast_ticker_block_t
+{
+	void *chain;
+	fw_kl_event_block_t event;
+} fw_kl_fast_ticker_block_t;
+
+typedef struct fw_kl_ticker_block_t
+{
+	void *chain;
+	uint16_t count;
+	uint16_t reload_count;
+	fw_kl_event_block_t event;
+} fw_kl_ticker_block_t;
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    #### CFWI-specific information: ####
+
+    An event routine is entered at interrupt time for asynchronous
+    events, so it cannot be a plain C function: SDCC code does not
+    preserve IY.  See cfwi_sched.h for a way to run C functions from
+    frame flyback and ticker events.
+
+    157: KL NEW FRAME FLY
+    #BCD7
+    Initialize and put a block onto the frame flyback list.
+    Action:
+    Initialize a frame flyback block and add it to the list of routines to be kicked on
+    each frame flyback.
+    Entry conditions:
+    HL contains the address of the frame flyback block.
+    B contains the event class.
+    C contains the ROM select address of the event routine.
+    DE contains the address of the event routine.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    The frame flyback block must lie in the central 32K of RAM. It is 9 bytes long: a
+    two byte chain pointer used by the Kernel followed by an event block.
+    The event block is initialized as for KL INIT EVENT. The block is then put onto the
+    frame flyback list as for KL ADD FRAME FLY; if it is already on the list it is not
+    put on again.
+    Frame flyback occurs every 1/50th of a second (1/60th on 60 Hz machines).
+    Related entries:
+    KL ADD FRAME FLY
+    KL DEL FRAME FLY
+    KL INIT EVENT
+    KL NEW FAST TICKER
+    MC WAIT FLYBACK
+*/
+void fw_kl_new_frame_fly(fw_kl_frame_flyback_block_t *block, uint8_t event_class, uint8_t rom_select, void *routine) __preserves_regs(iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    158: KL ADD FRAME FLY
+    #BCDA
+    Put a block onto the frame flyback list.
+    Action:
+    Add a frame flyback block, whose event block is already initialized, to the list of
+    routines to be kicked on each frame flyback.
+    Entry conditions:
+    HL contains the address of the frame flyback block.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    The frame flyback block must lie in the central 32K of RAM.
+    If the block is already on the frame flyback list then it is not put on again.
+    Related entries:
+    KL DEL FRAME FLY
+    KL NEW FRAME FLY
+*/
+void fw_kl_add_frame_fly(fw_kl_frame_flyback_block_t *block) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    159: KL DEL FRAME FLY
+    #BCDD
+    Remove a block from the frame flyback list.
+    Action:
+    Take a frame flyback block off the list of routines to be kicked on each frame
+    flyback.
+    Entry conditions:
+    HL contains the address of the frame flyback block.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    If the block is not on the frame flyback list then nothing happens.
+    The event may already have been kicked and be pending; removing the block from
+    the list does not discard such an outstanding event.
+    Related entries:
+    KL ADD FRAME FLY
+    KL NEW FRAME FLY
+*/
+void fw_kl_del_frame_fly(fw_kl_frame_flyback_block_t *block) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    160: KL NEW FAST TICKER
+    #BCE0
+    Initialize and put a block onto the fast ticker list.
+    Action:
+    Initialize a fast ticker block and add it to the list of routines to be kicked on each
+    fast ticker interrupt.
+    Entry conditions:
+    HL contains the address of the fast ticker block.
+    B contains the event class.
+    C contains the ROM select address of the event routine.
+    DE contains the address of the event routine.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    The fast ticker block must lie in the central 32K of RAM. It is 9 bytes long: a two
+    byte chain pointer used by the Kernel followed by an event block.
+    The event block is initialized as for KL INIT EVENT. The block is then put onto the
+    fast ticker list as for KL ADD FAST TICKER; if it is already on the list it is not put
+    on again.
+    The fast ticker interrupt occurs every 1/300th of a second.
+    Related entries:
+    KL ADD FAST TICKER
+    KL DEL FAST TICKER
+    KL INIT EVENT
+    KL NEW FRAME FLY
+*/
+void fw_kl_new_fast_ticker(fw_kl_fast_ticker_block_t *block, uint8_t event_class, uint8_t rom_select, void *routine) __preserves_regs(iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    161: KL ADD FAST TICKER
+    #BCE3
+    Put a block onto the fast ticker list.
+    Action:
+    Add a fast ticker block, whose event block is already initialized, to the list of
+    routines to be kicked on each fast ticker interrupt.
+    Entry conditions:
+    HL contains the address of the fast ticker block.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    The fast ticker block must lie in the central 32K of RAM.
+    If the block is already on the fast ticker list then it is not put on again.
+    Related entries:
+    KL DEL FAST TICKER
+    KL NEW FAST TICKER
+*/
+void fw_kl_add_fast_ticker(fw_kl_fast_ticker_block_t *block) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    162: KL DEL FAST TICKER
+    #BCE6
+    Remove a block from the fast ticker list.
+    Action:
+    Take a fast ticker block off the list of routines to be kicked on each fast ticker
+    interrupt.
+    Entry conditions:
+    HL contains the address of the fast ticker block.
+    Exit conditions:
+    AF, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    If the block is not on the fast ticker list then nothing happens.
+    Related entries:
+    KL ADD FAST TICKER
+    KL NEW FAST TICKER
+*/
+void fw_kl_del_fast_ticker(fw_kl_fast_ticker_block_t *block) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    163: KL ADD TICKER
+    #BCE9
+    Put a block onto the tick list.
+    Action:
+    Add a tick block, whose event block is already initialized, to the list of routines to
+    be run on each tick, and set its counts.
+    Entry conditions:
+    HL contains the address of the tick block.
+    DE contains the initial value for the tick count.
+    BC contains the value for the reload count.
+    Exit conditions:
+    AF, BC, DE and HL corrupt.
+    All other registers preserved.
+    Notes:
+    The tick block must lie in the central 32K of RAM. It is 13 bytes long: a two byte
+    chain pointer, the two byte tick count, the two byte reload count and the event
+    block.
+    Ticks occur every 1/50th of a second. On each tick the tick count is decremented;
+    when it reaches zero the event is kicked and the tick count is set to the reload count.
+    A tick count of zero means the block is ignored; hence a reload count of zero makes
+    the event a one shot.
+    If the block is already on the tick list then only its counts are changed.
+    Related entries:
+    KL DEL TICKER
+    KL INIT EVENT
+*/
+void fw_kl_add_ticker(fw_kl_ticker_block_t *block, uint16_t initial_count, uint16_t reload_count) __preserves_regs(iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    #### CFWI-specific information: ####
+
+    Returns the tick count left, or 0 if the block was not on the tick
+    list.
+
+    164: KL DEL TICKER
+    #BCEC
+    Remove a block from the tick list.
+    Action:
+    Take a tick block off the list of routines to be run on each tick.
+    Entry conditions:
+    HL contains the address of the tick block.
+    Exit conditions:
+    If the block was found on the tick list:
+    Carry true.
+    DE contains the tick count remaining.
+    If the block was not found on the tick list:
+    Carry false.
+    DE corrupt.
+    Always:
+    A, HL and other flags corrupt.
+    All other registers preserved.
+    Related entries:
+    KL ADD TICKER
+*/
+uint16_t fw_kl_del_ticker(fw_kl_ticker_block_t *block) __z88dk_fastcall __preserves_regs(b, c, iyh, iyl);
+
+/** WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+    #### CFWI-specific information: ####
+
+    Returns the address of the byte after the event block, where a
+    user field would go.
+
+    165: KL INIT EVENT
+    #BCEF
+    Initialize an event block.
+    Action:
+    Set the event class, the event routine address and ROM select, and zero the event
+    count of an event block.
+    Entry conditions:
+    HL contains the address of the event block.
+    B contains the event class.
+    C contains the ROM select address of the event routine.
+    DE contains the address of the event routine.
+    Exit conditions:
+    HL contains the address of the byte after the event block.
+    AF and DE corrupt.
+    All other registers preserved.
+    Notes:
+    The event block must lie in the central 32K of RAM.
+    The event class is encoded as follows:
+    Bit 0: Near address (the ROM select is ignored and the routine is called in the
+    current ROM state).
+    Bits 1..4: Synchronous event priority.
+    Bit 5: Must be zero.
+    Bit 6: Express event.
+    Bit 7: Asynchronous event.
+    Asynchronous event routines are run at interrupt time; normal ones just before
+    returning from the interrupt, with interrupts enabled, express ones immediately,
+    with interrupts disabled. They must preserve IX, IY and the alternate registers.
+    Synchronous events are queued and run when the foreground program polls for them.
+    Related entries:
+    KL ADD FRAME FLY
+    KL ADD TICKER
+    KL EVENT
+    KL NEW FAST TICKER
+    KL NEW FRAME FLY
+*/
+void *fw_kl_init_event(fw_kl_event_block_t *block, uint8_t event_class, uint8_t rom_select, void *routine) __preserves_regs(iyh, iyl);
+
 /** 167: KL SYNC RESET
     #BCF5
     Clear synchronous event queue.
@@ -0,0 +1,149 @@
+.module cfwi_bare
+
+; Bare mode: firmware off, minimal interrupt handler.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+VECTOR = 0x0038
+LOW_AREA = 0x0000
+LOW_SIZE = 0x40
+HIGH_AREA = 0xB900
+HIGH_SIZE = 0x500
+
+        .area _DATA
+
+_cfwi_bare_hook::
+        .ds     2
+_cfwi_bare_ticks::
+        .ds     2
+_cfwi_bare_frames::
+        .ds     1
+active:
+        .ds     1
+save_buffer:
+        .ds     2
+saved_vector:
+        .ds     3
+saved_gate_array:               ; firmware's BC'
+        .ds     2
+
+        .area _CODE
+
+; void cfwi_bare_enter(uint8_t *save_buffer) __z88dk_fastcall;
+_cfwi_bare_enter::
+        ld      a,(active)
+        or      a
+        ret     nz
+
+        di
+        inc     a
+        ld      (active),a
+        ld      (save_buffer),hl
+
+        exx
+        ld      (saved_gate_array),bc
+        ld      a,c
+        or      #0x0C           ; lower and upper ROM off, same mode
+        ld      c,a
+        out     (c),c
+        exx
+
+        push    hl
+        ld      hl,#VECTOR
+        ld      de,#saved_vector
+        ld      bc,#3
+        ldir
+        pop     hl
+
+        call    exchange
+
+        ld      a,#0xC3         ; jp handler
+        ld      (VECTOR),a
+        ld      hl,#handler
+        ld      (VECTOR+1),hl
+
+        ei
+        ret
+
+; uint8_t *cfwi_bare_leave(void);
+_cfwi_bare_leave::
+        ld      hl,#0
+        ld      a,(active)
+        or      a
+        ret     z
+
+        di
+        xor     a
+        ld      (active),a
+
+        ld      hl,(save_buffer)
+        push    hl
+        call    exchange
+
+        ld      hl,#saved_vector
+        ld      de,#VECTOR
+        ld      bc,#3
+        ldir
+        pop     hl
+
+        exx
+        ld      bc,(saved_gate_array)
+        out     (c),c           ; ROM state as the firmware left it
+        exx
+
+        ei
+        ret
+
+; Exchange the save buffer at hl, if not NULL, with the freed areas,
+; so that firmware data and program data each survive while the other
+; is in place.  16 NOPs per byte, about 1.1 frames in all.
+exchange:
+        ld      a,h
+        or      l
+        ret     z
+        ld      de,#LOW_AREA
+        ld      bc,#LOW_SIZE
+        call    exchange_bytes
+        ld      de,#HIGH_AREA
+        ld      bc,#HIGH_SIZE
+exchange_bytes:
+        ld      a,(de)          ; 2
+        ldi                     ; 5
+        dec     hl              ; 2
+        ld      (hl),a          ; 2
+        inc     hl              ; 2
+        jp      pe,exchange_bytes ; 3
+        ret
+
+; Interrupt handler, jumped to from 0x0038.
+handler:
+        push    af              ; 4
+        push    bc              ; 4
+        push    hl              ; 4
+        ld      hl,(_cfwi_bare_ticks)   ; 5
+        inc     hl              ; 2
+        ld      (_cfwi_bare_ticks),hl   ; 5
+        ld      b,#0xF5         ; 2
+        in      a,(c)           ; 4, PPI port B, bit 0 is frame flyback
+        rra                     ; 1
+        jr      nc,hook$        ; 3/2
+        ld      hl,#_cfwi_bare_frames
+        inc     (hl)
+hook$:
+        ld      hl,(_cfwi_bare_hook)    ; 5
+        ld      a,h             ; 1
+        or      l               ; 1
+        jr      z,done$         ; 3/2
+        push    de
+        push    iy
+        call    call_hl
+        pop     iy
+        pop     de
+done$:
+        pop     hl              ; 3
+        pop     bc              ; 3
+        pop     af              ; 3
+        ei                      ; 1
+        ret                     ; 3
+
+call_hl:
+        jp      (hl)
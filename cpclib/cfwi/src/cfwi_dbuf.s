@@ -0,0 +1,88 @@
+.module cfwi_dbuf
+
+; Double buffering: draw to a hidden screen bank, then flip.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+; Adjacent, so that flip swaps them with one 16-bit load and store.
+_cfwi_dbuf_visible_msb::
+        .ds     1
+_cfwi_dbuf_hidden_msb::
+        .ds     1
+_cfwi_dbuf_visible_line_table::
+        .ds     2
+_cfwi_dbuf_hidden_line_table::
+        .ds     2
+offset:
+        .ds     2
+
+        .area _CODE
+
+; void cfwi_dbuf_init (uint8_t hidden_msb, uint8_t **visible_table, uint8_t **hidden_table);
+_cfwi_dbuf_init::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        call    0xBC0B          ; SCR GET LOCATION
+        ld      (offset),hl
+        ld      (_cfwi_dbuf_visible_msb),a
+        ld      e,5(ix)
+        ld      d,6(ix)
+        ld      (_cfwi_dbuf_visible_line_table),de
+        call    fill_table
+
+        ld      a,4(ix)
+        ld      (_cfwi_dbuf_hidden_msb),a
+        ld      e,7(ix)
+        ld      d,8(ix)
+        ld      (_cfwi_dbuf_hidden_line_table),de
+        call    fill_table
+
+        pop     ix
+        jr      set_views
+
+; Fill a line table for a standard screen.
+; In: a = bank msb, de = table.
+fill_table:
+        ld      hl,(offset)
+        add     a,h
+        ld      h,a             ; hl = address of first line
+        ld      bc,#0xC828      ; 200 lines, R1 = 40
+        push    bc
+        push    hl
+        push    de
+        call    _cfwi_scr_line_table_fill
+        pop     af
+        pop     af
+        pop     af
+        ret
+
+; void cfwi_dbuf_flip (void);
+_cfwi_dbuf_flip::
+        ld      hl,(_cfwi_dbuf_visible_msb)
+        ld      a,l
+        ld      l,h
+        ld      h,a
+        ld      (_cfwi_dbuf_visible_msb),hl
+
+        ld      hl,(_cfwi_dbuf_visible_line_table)
+        ld      de,(_cfwi_dbuf_hidden_line_table)
+        ld      (_cfwi_dbuf_visible_line_table),de
+        ld      (_cfwi_dbuf_hidden_line_table),hl
+
+        call    0xBD19          ; MC WAIT FLYBACK
+
+; Point firmware VDUs and fast plot at the hidden bank, display the
+; visible one.  SCR SET BASE also programs the hardware, which
+; MC SCREEN OFFSET overrides before the frame starts.
+set_views:
+        ld      a,(_cfwi_dbuf_hidden_msb)
+        call    0xBC08          ; SCR SET BASE
+        ld      a,(_cfwi_dbuf_visible_msb)
+        ld      hl,(offset)
+        call    0xBD1F          ; MC SCREEN OFFSET
+        ld      hl,(_cfwi_dbuf_hidden_line_table)
+        ld      (_cfwi_fast_plot_line_table),hl
+        ret
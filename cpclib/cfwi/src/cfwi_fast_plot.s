@@ -0,0 +1,160 @@
+.module cfwi_fast_plot
+
+; State and helpers shared by the cfwi_fast_plot_* family.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+_cfwi_fast_plot_line_table::
+        .ds     2
+_cfwi_fast_plot_pen_byte::
+        .ds     1
+cfwi_fast_plot_mode::
+        .ds     1
+cfwi_fast_plot_clip_width::
+        .ds     2
+cfwi_fast_plot_clip_height::
+        .ds     1
+
+        .area _CODE
+
+; Pixel masks, indexed by the position of the pixel within its byte.
+mask_mode0:
+        .byte   0xAA, 0x55
+mask_mode1:
+        .byte   0x88, 0x44, 0x22, 0x11
+mask_mode2:
+        .byte   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+
+; void cfwi_fast_plot_setup (uint8_t mode, uint8_t **line_table);
+_cfwi_fast_plot_setup::
+        ld      hl,#2
+        add     hl,sp
+        ld      a,(hl)
+        ld      (cfwi_fast_plot_mode),a
+        inc     hl
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        ld      (_cfwi_fast_plot_line_table),de
+
+        ; clip to a standard screen: 160 << mode pixels, 200 lines
+        ld      hl,#160
+        or      a
+        jr      z,width_found$
+        ld      b,a
+double$:
+        add     hl,hl
+        djnz    double$
+width_found$:
+        ld      (cfwi_fast_plot_clip_width),hl
+        ld      a,#200
+        ld      (cfwi_fast_plot_clip_height),a
+
+        ld      l,#1
+        ; fall through
+
+; void cfwi_fast_plot_set_pen (uint8_t pen) __z88dk_fastcall;
+_cfwi_fast_plot_set_pen::
+        ld      a,(cfwi_fast_plot_mode)
+        call    cfwi_pen_byte
+        ld      (_cfwi_fast_plot_pen_byte),a
+        ret
+
+; void cfwi_fast_plot_set_clip (uint16_t width, uint8_t height);
+_cfwi_fast_plot_set_clip::
+        ld      hl,#2
+        add     hl,sp
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        inc     hl
+        ld      a,(hl)
+        ld      (cfwi_fast_plot_clip_width),de
+        ld      (cfwi_fast_plot_clip_height),a
+        ret
+
+; Fetch x and y pushed by the caller of a cfwi_fast_plot_* entry.
+; Called right at the entry, so arguments are 4 bytes above sp.
+; Out: de = x, a = y.  Corrupts hl.
+cfwi_fast_plot_get_args::
+        ld      hl,#4
+        add     hl,sp
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        inc     hl
+        ld      a,(hl)
+        ret
+
+; Check that a pixel is inside the clip rectangle.
+; In: de = x, a = y.  Out: carry set if inside, de and a preserved.
+; Corrupts bc, hl.
+cfwi_fast_plot_clip::
+        ld      hl,#cfwi_fast_plot_clip_height
+        cp      (hl)
+        ret     nc
+        ld      bc,(cfwi_fast_plot_clip_width)
+        ld      h,d
+        ld      l,e
+        or      a
+        sbc     hl,bc
+        ret
+
+; Locate a pixel in screen memory through the line table.
+; In: de = x, a = y.  Out: hl = byte address, c = pixel mask.
+; Corrupts af, b, de.
+; Mode 1: about 60 NOPs.
+cfwi_fast_plot_locate::
+        ld      l,a
+        ld      h,#0
+        add     hl,hl
+        ld      bc,(_cfwi_fast_plot_line_table)
+        add     hl,bc
+        ld      a,(hl)
+        inc     hl
+        ld      h,(hl)
+        ld      l,a
+
+        ld      a,(cfwi_fast_plot_mode)
+        dec     a
+        jr      z,mode1$
+        jp      p,mode2$
+        ; mode 0: 2 pixels per byte
+        ld      a,e
+        and     #1
+        ld      bc,#mask_mode0
+        srl     d
+        rr      e
+        jr      mask$
+mode1$:
+        ; mode 1: 4 pixels per byte
+        ld      a,e
+        and     #3
+        ld      bc,#mask_mode1
+        srl     d
+        rr      e
+        srl     d
+        rr      e
+        jr      mask$
+mode2$:
+        ; mode 2: 8 pixels per byte
+        ld      a,e
+        and     #7
+        ld      bc,#mask_mode2
+        srl     d
+        rr      e
+        srl     d
+        rr      e
+        srl     d
+        rr      e
+mask$:
+        add     hl,de
+        add     a,c
+        ld      c,a
+        adc     a,b
+        sub     c
+        ld      b,a
+        ld      a,(bc)
+        ld      c,a
+        ret
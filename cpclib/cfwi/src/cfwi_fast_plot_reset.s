@@ -0,0 +1,22 @@
+.module cfwi_fast_plot_reset
+
+; void cfwi_fast_plot_reset (uint16_t x, uint8_t y);
+; void cfwi_fast_plot_reset_clipped (uint16_t x, uint8_t y);
+; Plot a pixel with pen 0.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+_cfwi_fast_plot_reset_clipped::
+        call    cfwi_fast_plot_get_args
+        call    cfwi_fast_plot_clip
+        ret     nc
+        jr      plot_reset
+
+_cfwi_fast_plot_reset::
+        call    cfwi_fast_plot_get_args
+plot_reset:
+        call    cfwi_fast_plot_locate
+        ld      a,c
+        cpl
+        and     (hl)
+        ld      (hl),a
+        ret
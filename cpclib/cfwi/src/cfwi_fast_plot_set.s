@@ -0,0 +1,26 @@
+.module cfwi_fast_plot_set
+
+; void cfwi_fast_plot_set (uint16_t x, uint8_t y);
+; void cfwi_fast_plot_set_clipped (uint16_t x, uint8_t y);
+; Plot a pixel with the current pen.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+_cfwi_fast_plot_set_clipped::
+        call    cfwi_fast_plot_get_args
+        call    cfwi_fast_plot_clip
+        ret     nc
+        jr      plot_set
+
+_cfwi_fast_plot_set::
+        call    cfwi_fast_plot_get_args
+plot_set:
+        call    cfwi_fast_plot_locate
+        ld      a,c
+        cpl
+        and     (hl)
+        ld      b,a
+        ld      a,(_cfwi_fast_plot_pen_byte)
+        and     c
+        or      b
+        ld      (hl),a
+        ret
@@ -0,0 +1,22 @@
+.module cfwi_fast_plot_xor
+
+; void cfwi_fast_plot_xor (uint16_t x, uint8_t y);
+; void cfwi_fast_plot_xor_clipped (uint16_t x, uint8_t y);
+; Exclusive-or a pixel with the current pen.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+_cfwi_fast_plot_xor_clipped::
+        call    cfwi_fast_plot_get_args
+        call    cfwi_fast_plot_clip
+        ret     nc
+        jr      plot_xor
+
+_cfwi_fast_plot_xor::
+        call    cfwi_fast_plot_get_args
+plot_xor:
+        call    cfwi_fast_plot_locate
+        ld      a,(_cfwi_fast_plot_pen_byte)
+        and     c
+        xor     (hl)
+        ld      (hl),a
+        ret
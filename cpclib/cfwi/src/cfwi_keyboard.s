@@ -0,0 +1,50 @@
+.module cfwi_keyboard
+
+; Direct keyboard matrix scan through the PPI and PSG register 14.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+PPI_A = 0xF4                    ; PSG data
+PPI_C = 0xF6                    ; PSG control in bits 7-6, keyboard line in bits 3-0
+PSG_READ = 0x40
+
+        .area _DATA
+
+_cfwi_keyboard_matrix::
+        .ds     10
+
+        .area _CODE
+
+; void cfwi_keyboard_scan(void);
+_cfwi_keyboard_scan::
+        ld      a,i             ; P/V = interrupts enabled
+        push    af
+        di
+
+        ld      bc,#0xF40E      ; PSG register 14, keyboard
+        out     (c),c
+        ld      bc,#0xF6C0      ; PSG select register
+        out     (c),c
+        ld      c,#0            ; PSG inactive
+        out     (c),c
+        ld      bc,#0xF792      ; PPI control, port A input
+        out     (c),c
+
+        ld      hl,#_cfwi_keyboard_matrix
+        ld      c,#PSG_READ     ; line 0
+        .rept 10
+        ld      b,#PPI_C        ; 2
+        out     (c),c           ; 4, select line and read
+        ld      b,#PPI_A        ; 2
+        ini                     ; 5, B is used before being decremented
+        inc     c               ; 1
+        .endm
+
+        ld      bc,#0xF782      ; PPI control, port A output again
+        out     (c),c
+        ld      bc,#0xF600      ; PSG inactive
+        out     (c),c
+
+        pop     af
+        ret     po
+        ei
+        ret
@@ -0,0 +1,89 @@
+.module cfwi_palette_cycle_build
+
+; void cfwi_palette_cycle_build (ink_vector16 *ramp, const ink_vector16 *base, uint8_t first_ink, uint8_t last_ink);
+; Fill ramp with last_ink - first_ink + 1 copies of base, inks
+; first_ink to last_ink rotated by one more position in each copy.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+len:
+        .ds     1
+
+        .area _CODE
+
+_cfwi_palette_cycle_build::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      a,9(ix)
+        sub     8(ix)
+        jr      c,done
+        inc     a
+        ld      (len),a
+
+        ld      e,4(ix)
+        ld      d,5(ix)         ; de = current palette
+        ld      c,#0            ; c = rotation
+palette:
+        ld      l,6(ix)
+        ld      h,7(ix)
+        push    de
+        push    bc
+        ld      bc,#17
+        ldir
+        pop     bc
+        pop     de
+
+        ld      b,#0            ; b = position in the cycle
+rotate:
+        ; a = (b + c) mod len
+        ld      a,(len)
+        ld      l,a
+        ld      a,b
+        add     a,c
+        cp      l
+        jr      c,source_found
+        sub     l
+source_found:
+        ; base[first_ink + 1 + a], border comes first
+        add     a,8(ix)
+        inc     a
+        ld      l,6(ix)
+        ld      h,7(ix)
+        add     a,l
+        ld      l,a
+        adc     a,h
+        sub     l
+        ld      h,a
+        ld      a,(hl)
+        push    af
+        ; palette[first_ink + 1 + b]
+        ld      a,b
+        add     a,8(ix)
+        inc     a
+        add     a,e
+        ld      l,a
+        adc     a,d
+        sub     l
+        ld      h,a
+        pop     af
+        ld      (hl),a
+
+        inc     b
+        ld      a,(len)
+        cp      b
+        jr      nz,rotate
+
+        ld      hl,#17
+        add     hl,de
+        ex      de,hl
+        inc     c
+        ld      a,(len)
+        cp      c
+        jr      nz,palette
+
+done:
+        pop     ix
+        ret
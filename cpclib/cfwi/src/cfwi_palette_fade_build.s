@@ -0,0 +1,217 @@
+.module cfwi_palette_fade_build
+
+; void cfwi_palette_fade_build (ink_vector16 *ramp, const ink_vector16 *from, const ink_vector16 *to, uint8_t steps);
+; Fill ramp with steps palettes going from "from" to "to".
+;
+; Each red, green and blue level (0 to 2) of each ink is interpolated
+; with rounding, as an integer part and a remainder, so that no
+; division is needed.  Runs once, ahead of the fade.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+n:                              ; steps - 1
+        .ds     1
+from_rgb:
+        .ds     1
+to_rgb:
+        .ds     1
+; For red, green, blue: level, remainder, difference.
+comp:
+        .ds     9
+
+        .area _CODE
+
+; Levels of each hardware colour, packed as red << 4 | green << 2 | blue.
+hw_to_rgb_table:
+        .byte   0x15, 0x15, 0x09, 0x29, 0x01, 0x21, 0x05, 0x25
+        .byte   0x21, 0x29, 0x28, 0x2A, 0x20, 0x22, 0x24, 0x26
+        .byte   0x01, 0x09, 0x08, 0x0A, 0x00, 0x02, 0x04, 0x06
+        .byte   0x11, 0x19, 0x18, 0x1A, 0x10, 0x12, 0x14, 0x16
+
+; Hardware colour of each red * 9 + green * 3 + blue.
+rgb_to_hw_table:
+        .byte   20, 4, 21, 22, 6, 23, 18, 2, 19
+        .byte   28, 24, 29, 30, 0, 31, 26, 25, 27
+        .byte   12, 5, 13, 14, 7, 15, 10, 3, 11
+
+_cfwi_palette_fade_build::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      a,10(ix)
+        or      a
+        jr      z,done
+        dec     a
+        ld      (n),a
+        ld      c,#0            ; c = index in ink vector
+ink:
+        push    bc
+        ld      b,#0
+        ld      l,6(ix)
+        ld      h,7(ix)
+        add     hl,bc
+        ld      a,(hl)
+        call    hw_to_rgb
+        ld      (from_rgb),a
+        ld      l,8(ix)
+        ld      h,9(ix)
+        add     hl,bc
+        ld      a,(hl)
+        call    hw_to_rgb
+        ld      (to_rgb),a
+        call    init_components
+
+        pop     bc
+        push    bc
+        ld      b,#0
+        ld      l,4(ix)
+        ld      h,5(ix)
+        add     hl,bc           ; hl = ink in first palette
+        ld      b,10(ix)
+step:
+        push    bc
+        push    hl
+        call    current_hw
+        pop     hl
+        ld      (hl),a
+        ld      de,#17
+        add     hl,de
+        push    hl
+        call    advance_components
+        pop     hl
+        pop     bc
+        djnz    step
+
+        pop     bc
+        inc     c
+        ld      a,c
+        cp      #17
+        jr      nz,ink
+
+done:
+        pop     ix
+        ret
+
+; In: a = hardware colour.  Out: a = packed levels.  Corrupts de, hl.
+hw_to_rgb:
+        and     #0x1F
+        ld      e,a
+        ld      d,#0
+        ld      hl,#hw_to_rgb_table
+        add     hl,de
+        ld      a,(hl)
+        ret
+
+; Level of the component in bits 5-4 of a.
+top_component:
+        rrca
+        rrca
+        rrca
+        rrca
+        and     #3
+        ret
+
+; Start each component at its "from" level, remainder n / 2.
+; With a single step, start (and stay) at "to".
+; Corrupts af, bc, de, hl.
+init_components:
+        ld      a,(from_rgb)
+        ld      d,a
+        ld      a,(to_rgb)
+        ld      e,a
+        ld      a,(n)
+        or      a
+        jr      nz,init
+        ld      d,e
+init:
+        srl     a
+        ld      c,a
+        ld      hl,#comp
+        ld      b,#3
+init_one:
+        ld      a,e
+        call    top_component
+        ld      (hl),a          ; "to" level, for now
+        ld      a,d
+        call    top_component
+        push    bc
+        ld      b,a
+        ld      a,(hl)
+        sub     b               ; difference
+        ld      (hl),b          ; level
+        inc     hl
+        ld      (hl),c          ; remainder
+        inc     hl
+        ld      (hl),a          ; difference
+        inc     hl
+        pop     bc
+        sla     d
+        sla     d
+        sla     e
+        sla     e
+        djnz    init_one
+        ret
+
+; Add difference to remainder of each component, carry to level.
+; Corrupts af, bc, d, hl.
+advance_components:
+        ld      a,(n)
+        or      a
+        ret     z
+        ld      c,a
+        ld      hl,#comp
+        ld      b,#3
+advance_one:
+        ld      d,(hl)          ; level
+        inc     hl
+        ld      a,(hl)          ; remainder
+        inc     hl
+        add     a,(hl)          ; plus difference
+normalize_low:
+        bit     7,a
+        jr      z,normalize_high
+        add     a,c
+        dec     d
+        jr      normalize_low
+normalize_high:
+        cp      c
+        jr      c,normalized
+        sub     c
+        inc     d
+        jr      normalize_high
+normalized:
+        dec     hl
+        ld      (hl),a
+        dec     hl
+        ld      (hl),d
+        inc     hl
+        inc     hl
+        inc     hl
+        djnz    advance_one
+        ret
+
+; Out: a = hardware colour of current levels.  Corrupts bc, de, hl.
+current_hw:
+        ld      a,(comp)
+        ld      b,a
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,b             ; red * 9
+        ld      b,a
+        ld      a,(comp + 3)
+        ld      c,a
+        add     a,a
+        add     a,c             ; green * 3
+        add     a,b
+        ld      b,a
+        ld      a,(comp + 6)    ; blue
+        add     a,b
+        ld      e,a
+        ld      d,#0
+        ld      hl,#rgb_to_hw_table
+        add     hl,de
+        ld      a,(hl)
+        ret
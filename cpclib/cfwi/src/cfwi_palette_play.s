@@ -0,0 +1,65 @@
+.module cfwi_palette_play
+
+; void cfwi_palette_play (const ink_vector16 *ramp, uint8_t count, bool loop);
+; bool cfwi_palette_step (void);
+; Play a ramp of palettes, one per call to cfwi_palette_step, through
+; MC SET INKS.
+; cfwi_palette_step: 40 NOPs plus MC SET INKS.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+start:
+        .ds     2
+current:
+        .ds     2
+count:
+        .ds     1
+remaining:
+        .ds     1
+looping:
+        .ds     1
+
+        .area _CODE
+
+_cfwi_palette_play::
+        ld      hl,#2
+        add     hl,sp
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        inc     hl
+        ld      (start),de
+        ld      (current),de
+        ld      a,(hl)
+        ld      (count),a
+        ld      (remaining),a
+        inc     hl
+        ld      a,(hl)
+        ld      (looping),a
+        ret
+
+_cfwi_palette_step::
+        ld      l,#0
+        ld      a,(remaining)
+        or      a
+        jr      nz,apply
+        ld      a,(looping)
+        or      a
+        ret     z
+        ld      a,(count)
+        or      a
+        ret     z
+        ld      (remaining),a
+        ld      de,(start)
+        ld      (current),de
+apply:
+        ld      de,(current)
+        call    0xBD25          ; MC SET INKS
+        ld      hl,#17
+        add     hl,de
+        ld      (current),hl
+        ld      hl,#remaining
+        dec     (hl)
+        ld      l,#1
+        ret
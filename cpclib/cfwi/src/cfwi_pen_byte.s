@@ -0,0 +1,31 @@
+.module cfwi_pen_byte
+
+; Screen byte whose pixels all have a given pen.
+; In: a = mode (0, 1 or 2), l = pen.  Out: a = byte.
+; Corrupts bc, de, hl.
+
+; Bits of the byte for each bit of the pen (bit 0 first), 4 entries
+; per mode.
+pen_bits:
+        .byte   0xC0, 0x0C, 0x30, 0x03
+        .byte   0xF0, 0x0F, 0x00, 0x00
+        .byte   0xFF, 0x00, 0x00, 0x00
+
+cfwi_pen_byte::
+        ld      c,l
+        add     a,a
+        add     a,a
+        ld      e,a
+        ld      d,#0
+        ld      hl,#pen_bits
+        add     hl,de
+        ld      b,#4
+        xor     a
+pen_bit$:
+        srl     c
+        jr      nc,next_pen_bit$
+        or      (hl)
+next_pen_bit$:
+        inc     hl
+        djnz    pen_bit$
+        ret
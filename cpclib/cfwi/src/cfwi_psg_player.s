@@ -0,0 +1,268 @@
+.module cfwi_psg_player
+
+; Direct PSG player of delta-compressed register frame streams.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+PPI_A = 0xF4                    ; PSG data
+PPI_C = 0xF6                    ; PSG control in bits 7-6
+PSG_WRITE = 0x80
+PSG_SELECT = 0xC0
+
+END_BIT = 7                     ; in second mask byte
+WAIT_BIT = 6
+
+; stream state
+POS = 0                         ; next frame, 0 when stopped
+LOOP = 2                        ; loop frame, 0 if none
+WAIT = 4                        ; frames left without change
+REGS = 5                        ; last values of registers 0 to 13
+STREAM_SIZE = 19
+
+        .area _DATA
+
+music:
+        .ds     STREAM_SIZE
+effect:
+        .ds     STREAM_SIZE
+effect_mask:                    ; registers taken over by the effect
+        .ds     2
+
+        .area _CODE
+
+; void cfwi_psg_player_start(const uint8_t *stream) __z88dk_fastcall;
+_cfwi_psg_player_start::
+        push    ix
+        ld      ix,#music
+        call    open
+        pop     ix
+        ld      hl,#0
+        ld      (effect+POS),hl
+        ld      (effect_mask),hl
+        ret
+
+; void cfwi_psg_player_effect(const uint8_t *stream) __z88dk_fastcall;
+_cfwi_psg_player_effect::
+        push    ix
+        ld      ix,#effect
+        call    open            ; bc = registers used
+        pop     ix
+        ld      hl,(effect_mask)
+        ld      (effect_mask),bc
+
+        ld      a,c             ; give back registers the new effect does not use
+        cpl
+        and     l
+        ld      e,a
+        ld      a,b
+        cpl
+        and     h
+        and     #0x1F           ; but register 13
+        ld      d,a
+        ld      hl,#music+REGS
+        jp      psg_write
+
+; void cfwi_psg_player_frame(void);
+_cfwi_psg_player_frame::
+        push    ix
+        ld      ix,#music
+        call    next_frame      ; de = registers changed
+        ld      hl,(effect_mask)
+        ld      a,l             ; only those the effect leaves to music
+        cpl
+        and     e
+        ld      e,a
+        ld      a,h
+        cpl
+        and     d
+        ld      d,a
+        ld      hl,#music+REGS
+        call    psg_write
+
+        ld      ix,#effect
+        ld      a,POS(ix)
+        or      POS+1(ix)
+        jr      z,done$         ; no effect
+        call    next_frame
+        ld      hl,#effect+REGS
+        call    psg_write
+        ld      a,POS(ix)
+        or      POS+1(ix)
+        jr      nz,done$
+
+        ld      de,(effect_mask) ; effect ended, give its registers back
+        ld      hl,#0
+        ld      (effect_mask),hl
+        ld      a,d
+        and     #0x1F           ; but register 13
+        ld      d,a
+        ld      hl,#music+REGS
+        call    psg_write
+done$:
+        pop     ix
+        ret
+
+; void cfwi_psg_player_stop(void);
+_cfwi_psg_player_stop::
+        ld      hl,#0
+        ld      (music+POS),hl
+        ld      (effect+POS),hl
+        ld      (effect_mask),hl
+        ld      de,#0x0780      ; registers 7 to 10
+        ld      hl,#silence
+        jp      psg_write
+
+silence:
+        .db     0, 0, 0, 0, 0, 0, 0
+        .db     0x3F            ; mixer: all off, port A input
+        .db     0, 0, 0         ; volumes
+
+; Set up a stream state.
+; in: ix = stream state, hl = stream
+; out: bc = registers written by the stream
+; corrupts: af, de, hl
+open:
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)          ; loop offset
+        inc     hl
+        ld      c,(hl)
+        inc     hl
+        ld      b,(hl)          ; registers used
+        inc     hl              ; first frame
+        ld      POS(ix),l
+        ld      POS+1(ix),h
+        ld      WAIT(ix),#0
+        ld      a,d
+        and     e
+        inc     a
+        jr      nz,loop$
+        ld      l,a             ; 0xFFFF: no loop
+        ld      h,a
+        jr      store$
+loop$:
+        add     hl,de
+store$:
+        ld      LOOP(ix),l
+        ld      LOOP+1(ix),h
+        ret
+
+; Advance a stream by one frame.
+; in: ix = stream state
+; out: de = registers changed, their values are now in REGS(ix)
+; corrupts: af, bc, hl
+next_frame:
+        ld      de,#0
+        ld      l,POS(ix)
+        ld      h,POS+1(ix)
+        ld      a,h
+        or      l
+        ret     z               ; stopped
+        ld      a,WAIT(ix)
+        or      a
+        jr      z,read$
+        dec     WAIT(ix)
+        ret
+
+end$:
+        ld      l,LOOP(ix)
+        ld      h,LOOP+1(ix)
+        ld      a,h
+        or      l
+        jr      nz,read$
+        ld      e,a             ; no loop: stop
+        ld      d,a
+        jr      store$
+
+read$:
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)          ; mask
+        inc     hl
+        bit     END_BIT,d
+        jr      nz,end$
+        bit     WAIT_BIT,d
+        jr      z,values$
+        dec     e               ; this frame is the first one without change
+        ld      WAIT(ix),e
+        ld      de,#0
+        jr      store$
+
+values$:
+        push    de
+        ld      c,e
+        ld      b,d             ; bc = mask
+        push    ix
+        pop     de
+        ld      a,e
+        add     a,#REGS
+        ld      e,a
+        adc     a,d
+        sub     e
+        ld      d,a             ; de = REGS(ix)
+scatter$:
+        srl     b               ; 2
+        rr      c               ; 2
+        jr      nc,skip$        ; 2/3
+        ld      a,(hl)          ; 2
+        ld      (de),a          ; 2
+        inc     hl              ; 2
+skip$:
+        inc     de              ; 2
+        ld      a,b             ; 1
+        or      c               ; 1
+        jr      nz,scatter$     ; 3
+        pop     de
+
+store$:
+        ld      POS(ix),l
+        ld      POS+1(ix),h
+        ret
+
+; Write registers to the PSG, with interrupts disabled.
+; in: de = registers to write, bit n for register n, hl = values of registers 0 to 13
+; corrupts: af, bc, de, hl
+psg_write:
+        ld      a,d
+        or      e
+        ret     z
+
+        ld      a,i             ; P/V = interrupts enabled
+        push    af
+        di
+
+        ld      c,#0            ; register number
+reg$:
+        srl     d               ; 2
+        rr      e               ; 2
+        jr      nc,next$        ; 2/3
+        ld      b,#PPI_A        ; 2
+        out     (c),c           ; 4, register number
+        ld      b,#PPI_C        ; 2
+        ld      a,#PSG_SELECT   ; 2
+        out     (c),a           ; 4, select register
+        xor     a               ; 1
+        out     (c),a           ; 4, inactive
+        ld      b,#PPI_A+1      ; 2
+        outi                    ; 5, value, B is decremented before being used
+        ld      b,#PPI_C        ; 2
+        ld      a,#PSG_WRITE    ; 2
+        out     (c),a           ; 4, write register
+        xor     a               ; 1
+        out     (c),a           ; 4, inactive
+        inc     c               ; 1
+        ld      a,d             ; 1
+        or      e               ; 1
+        jr      nz,reg$         ; 3
+        jr      done$
+next$:
+        inc     hl              ; 2
+        inc     c               ; 1
+        ld      a,d             ; 1
+        or      e               ; 1
+        jr      nz,reg$         ; 3
+
+done$:
+        pop     af
+        ret     po
+        ei
+        ret
@@ -0,0 +1,174 @@
+.module cfwi_raster
+
+; Raster palette splits from an express fast ticker event.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+ZONE_MAX = 6
+ZONE_STRIDE = 17                ; Gate Array values of one zone
+EVENT_CLASS = 0xC1              ; asynchronous, express, near address
+
+        .area _DATA
+
+block:                          ; fast ticker block
+        .ds     9
+zone_index:
+        .ds     1
+zone_count:
+        .ds     1
+first_pen:                      ; first_pen and port are loaded together in bc
+        .ds     1
+port:
+        .ds     1
+pen_count:
+        .ds     1
+zone_inks:
+        .ds     ZONE_MAX * ZONE_STRIDE
+
+        .area _CODE
+
+; void cfwi_raster_start(const ink_vector16 *zones, uint8_t zone_count, uint8_t first_pen, uint8_t pen_count);
+_cfwi_raster_start::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      a,#ZONE_MAX
+        ld      (zone_index),a  ; wait for frame flyback
+        ld      a,#0x7F
+        ld      (port),a
+        ld      a,6(ix)
+        ld      (zone_count),a
+        ld      a,7(ix)
+        ld      (first_pen),a
+        ld      a,8(ix)
+        ld      (pen_count),a
+
+        ld      l,4(ix)
+        ld      h,5(ix)         ; zones
+        xor     a
+zones$:
+        push    af
+        push    hl
+        call    convert
+        pop     hl
+        ld      de,#17          ; sizeof(ink_vector16)
+        add     hl,de
+        pop     af
+        inc     a
+        cp      6(ix)
+        jr      nz,zones$
+
+        pop     ix
+
+        ld      hl,#block
+        ld      bc,#EVENT_CLASS << 8
+        ld      de,#raster_event
+        jp      0xBCE0          ; KL NEW FAST TICKER
+
+; void cfwi_raster_set_zone(uint8_t zone, const ink_vector16 *inks);
+_cfwi_raster_set_zone::
+        ld      hl,#2
+        add     hl,sp
+        ld      a,(hl)          ; zone
+        inc     hl
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        ex      de,hl           ; inks
+        di
+        call    convert
+        ei
+        ret
+
+; void cfwi_raster_stop(void);
+_cfwi_raster_stop::
+        ld      hl,#block
+        jp      0xBCE6          ; KL DEL FAST TICKER
+
+; Store the Gate Array values of a zone.
+; in: a = zone, hl = ink_vector16
+; corrupts: af, bc, de, hl
+convert:
+        ex      de,hl
+        ld      l,a
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,l             ; zone * ZONE_STRIDE
+        ld      hl,#zone_inks
+        add     a,l
+        ld      l,a
+        adc     a,h
+        sub     l
+        ld      h,a
+
+        ld      a,(pen_count)
+        ld      b,a
+        ld      a,(first_pen)
+        ld      c,a
+pen$:
+        push    de
+        ld      a,c
+        inc     a               ; as_array index of pens 0 to 15
+        cp      #17
+        jr      c,index$
+        xor     a               ; border is first in ink_vector16
+index$:
+        add     a,e
+        ld      e,a
+        adc     a,d
+        sub     e
+        ld      d,a
+        ld      a,(de)
+        or      #0x40           ; Gate Array: set colour of selected pen
+        ld      (hl),a
+        inc     hl
+        inc     c
+        pop     de
+        djnz    pen$
+        ret
+
+; Event routine, at each interrupt with interrupts disabled.
+raster_event:
+        ld      b,#0xF5
+        in      a,(c)           ; PPI port B, bit 0 is frame flyback
+        rra
+        ld      hl,#zone_index
+        ld      a,#0
+        jr      c,zone$
+        ld      a,(hl)
+        inc     a
+        cp      #ZONE_MAX
+        ret     nc              ; lost sync, wait for frame flyback
+zone$:
+        ld      (hl),a
+        ld      hl,#zone_count
+        cp      (hl)
+        ret     nc
+
+        ld      c,a
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,c             ; zone * ZONE_STRIDE
+        ld      hl,#zone_inks
+        add     a,l
+        ld      l,a
+        adc     a,h
+        sub     l
+        ld      h,a
+
+        ld      a,(pen_count)
+        ld      e,a
+        ld      bc,(first_pen)  ; b = Gate Array port, c = pen
+write$:
+        out     (c),c           ; 4, select pen
+        ld      a,(hl)          ; 2
+        inc     hl              ; 2
+        out     (c),a           ; 4, set its colour
+        inc     c               ; 1
+        dec     e               ; 1
+        jr      nz,write$       ; 3
+        ret
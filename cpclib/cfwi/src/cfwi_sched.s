@@ -0,0 +1,108 @@
+.module cfwi_sched
+
+; Run C functions from frame flyback, fast ticker and ticker events.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+; Layout of cfwi_sched_slot_t: a 13-byte union of firmware blocks,
+; then kind, then trampoline.
+SLOT_KIND = 13
+TICKER_EVENT_BLOCK = 6          ; after chain, count and reload count
+
+KIND_NONE = 0
+KIND_FRAME_FLY = 1
+KIND_FAST_TICKER = 2
+KIND_TICKER = 3
+
+EVENT_CLASS = 0x81              ; asynchronous, near address
+
+        .area _CODE
+
+; void cfwi_sched_every_frame(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback);
+_cfwi_sched_every_frame::
+        ld      a,#KIND_FRAME_FLY
+        call    prepare
+        jp      0xBCD7          ; KL NEW FRAME FLY
+
+; void cfwi_sched_fast(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback);
+_cfwi_sched_fast::
+        ld      a,#KIND_FAST_TICKER
+        call    prepare
+        jp      0xBCE0          ; KL NEW FAST TICKER
+
+; void cfwi_sched_every_n_frames(cfwi_sched_slot_t *slot, cfwi_sched_callback_t callback, uint16_t frame_count);
+_cfwi_sched_every_n_frames::
+        ld      a,#KIND_TICKER
+        call    prepare
+        push    hl
+        ld      a,#TICKER_EVENT_BLOCK
+        add     a,l
+        ld      l,a
+        adc     a,h
+        sub     l
+        ld      h,a
+        call    0xBCEF          ; KL INIT EVENT
+        pop     de              ; slot
+        ld      hl,#6
+        add     hl,sp
+        ld      c,(hl)          ; frame_count, LSB
+        inc     hl
+        ld      b,(hl)          ; frame_count, MSB
+        ex      de,hl
+        ld      e,c
+        ld      d,b             ; first kick after frame_count ticks too
+        jp      0xBCE9          ; KL ADD TICKER
+
+; void cfwi_sched_cancel(cfwi_sched_slot_t *slot) __z88dk_fastcall;
+_cfwi_sched_cancel::
+        ld      de,#SLOT_KIND
+        ex      de,hl
+        add     hl,de
+        ld      a,(hl)
+        ld      (hl),#KIND_NONE
+        ex      de,hl           ; slot
+        dec     a
+        jp      z,0xBCDD        ; KL DEL FRAME FLY
+        dec     a
+        jp      z,0xBCE6        ; KL DEL FAST TICKER
+        dec     a
+        ret     nz
+        jp      0xBCEC          ; KL DEL TICKER
+
+; Record kind and generate the trampoline of a slot.
+; in: a = kind, slot and callback as first two arguments of the caller
+; out: hl = slot, de = trampoline, b = event class, c = ROM select
+; corrupts: af
+prepare:
+        ld      hl,#4
+        add     hl,sp
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)          ; slot
+        inc     hl
+        ld      c,(hl)
+        inc     hl
+        ld      b,(hl)          ; callback
+        ld      hl,#SLOT_KIND
+        add     hl,de
+        ld      (hl),a
+        inc     hl
+        push    hl              ; trampoline
+        ld      (hl),#0xFD      ; push iy
+        inc     hl
+        ld      (hl),#0xE5
+        inc     hl
+        ld      (hl),#0xCD      ; call callback
+        inc     hl
+        ld      (hl),c
+        inc     hl
+        ld      (hl),b
+        inc     hl
+        ld      (hl),#0xFD      ; pop iy
+        inc     hl
+        ld      (hl),#0xE1
+        inc     hl
+        ld      (hl),#0xC9      ; ret
+        ex      de,hl           ; slot
+        pop     de              ; trampoline
+        ld      bc,#EVENT_CLASS << 8    ; ROM select is ignored for a near address
+        ret
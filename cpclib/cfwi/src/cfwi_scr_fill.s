@@ -0,0 +1,56 @@
+.module cfwi_scr_fill
+
+; void cfwi_scr_fill (uint8_t bank_msb, uint8_t byte);
+; void cfwi_scr_fill__fastcall (uint16_t bank_msb8h_byte8l) __z88dk_fastcall;
+; Fill a whole 16K screen bank with byte, using PUSH.
+;
+; The bank is filled from the top down in 1K chunks, SP pointing into
+; screen memory with interrupts disabled.  Interrupts are enabled for
+; one instruction between chunks, each chunk taking less time than
+; between two interrupts, so that none is lost.
+;
+; About 35000 NOPs (1.8 frames), 4 times faster than a byte loop.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+saved_sp:
+        .ds     2
+
+        .area _CODE
+
+_cfwi_scr_fill::
+        ld      hl,#2
+        add     hl,sp
+        ld      a,(hl)
+        inc     hl
+        ld      l,(hl)
+        ld      h,a
+
+_cfwi_scr_fill__fastcall::
+        ld      d,l
+        ld      e,l             ; de = byte, twice
+        ld      a,h
+        add     a,#0x40
+        ld      h,a
+        ld      l,#0            ; hl = end of bank
+        ld      c,#16           ; 16 chunks of 1K
+
+chunk$:
+        di
+        ld      (saved_sp),sp
+        ld      sp,hl
+        ld      b,#16           ; 16 times 32 PUSH, 1K
+push$:
+        .rept   32
+        push    de
+        .endm
+        djnz    push$
+        ld      sp,(saved_sp)
+        ei
+        ld      a,h
+        sub     #4
+        ld      h,a
+        dec     c
+        jr      nz,chunk$
+        ret
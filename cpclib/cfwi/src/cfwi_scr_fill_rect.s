@@ -0,0 +1,100 @@
+.module cfwi_scr_fill_rect
+
+; void cfwi_scr_fill_rect (uint8_t *top_left, uint8_t width, uint8_t height, uint8_t byte);
+; Fill a rectangle of screen memory with byte, using PUSH.
+;
+; top_left is the screen address of the top left byte, width is in
+; bytes (at most 80) and the rectangle may cross character rows.
+; Screen lines are 80 bytes wide (CRTC R1 = 40).  Each line is
+; filled from its end with interrupts disabled, jumping into an
+; unrolled block of PUSH at the entry matching the width.  An odd
+; width gets its last byte written separately.
+;
+; 2 NOPs per byte, about 30 per line, 9 more per character row
+; crossed.  A full 80x200 rectangle takes about 38000 NOPs.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+CHAR_ROW_BYTES = 0x50
+MAX_PUSHES = 40
+
+        .area _DATA
+
+saved_sp:
+        .ds     2
+
+        .area _CODE
+
+_cfwi_scr_fill_rect::
+        push    ix
+        ld      hl,#4
+        add     hl,sp
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)          ; de = top_left
+        inc     hl
+        ld      c,(hl)          ; c = width
+        inc     hl
+        ld      b,(hl)          ; b = height
+        inc     hl
+        ld      a,(hl)          ; a = byte
+        ld      (saved_sp),sp
+
+        ; hl = end of first line
+        ld      l,c
+        ld      h,#0
+        add     hl,de
+        ld      d,a
+        ld      e,a             ; de = byte, twice
+
+        ; ix = fill_end - width / 2
+        ld      a,c
+        srl     a
+        neg
+        push    bc
+        ld      c,a
+        sbc     a,a
+        ld      b,a
+        ld      ix,#fill_end
+        add     ix,bc
+        pop     bc
+
+        ld      a,b
+        or      a
+        jr      z,done
+
+line:
+        bit     0,c
+        jr      z,even
+        dec     hl
+        ld      (hl),e
+        di
+        ld      sp,hl
+        inc     hl
+        jp      (ix)
+even:
+        di
+        ld      sp,hl
+        jp      (ix)
+        .rept   MAX_PUSHES
+        push    de
+        .endm
+fill_end:
+        ld      sp,(saved_sp)
+        ei
+        ld      a,h
+        add     a,#8
+        ld      h,a
+        and     #0x38
+        jr      nz,next_line
+        ld      a,l
+        add     a,#CHAR_ROW_BYTES
+        ld      l,a
+        ld      a,h
+        adc     a,#0xC0
+        ld      h,a
+next_line:
+        djnz    line
+
+done:
+        pop     ix
+        ret
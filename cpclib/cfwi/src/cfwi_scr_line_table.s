@@ -0,0 +1,10 @@
+.module cfwi_scr_line_table
+
+; uint8_t *cfwi_scr_line_table[CFWI_SCR_LINE_TABLE_LINES];
+; Storage for the line address table of a standard 200-line screen.
+; Only linked in when referenced.
+
+        .area _DATA
+
+_cfwi_scr_line_table::
+        .ds     200 * 2
@@ -0,0 +1,94 @@
+.module cfwi_scr_line_table_fill
+
+; void cfwi_scr_line_table_fill (uint8_t **table, uint8_t *first_line, uint8_t crtc_r1, uint8_t line_count);
+; Fill table[0..line_count-1] with the address of each screen line.
+; Lines are generated from the last one up, each stored with PUSH.
+; Runs with interrupts disabled, returns with interrupts enabled.
+; 17 NOPs per line (200 lines: about 3.5 ms), plus 7 per character row.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+_cfwi_scr_line_table_fill::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      a,9(ix)         ; line_count
+        or      a
+        jr      z,done$
+
+        ; hl = end of table = table + 2 * line_count
+        ld      l,a
+        ld      h,#0
+        add     hl,hl
+        ld      e,4(ix)
+        ld      d,5(ix)
+        add     hl,de
+        push    hl
+
+        ; hl = first_line + ((line_count - 1) & 7) * 0x800
+        dec     a
+        ld      c,a
+        and     #7
+        add     a,a
+        add     a,a
+        add     a,a
+        add     a,7(ix)
+        ld      h,a
+        ld      l,6(ix)
+
+        ; de = bytes per character row = 2 * R1
+        ld      a,8(ix)
+        add     a,a
+        ld      e,a
+        ld      d,#0
+
+        ; hl += ((line_count - 1) >> 3) * de, address of the last line
+        ld      a,c
+        rrca
+        rrca
+        rrca
+        and     #0x1f
+        jr      z,last_line_found$
+row$:
+        add     hl,de
+        dec     a
+        jr      nz,row$
+last_line_found$:
+
+        ; de = 0x3800 - bytes per character row: from the top line of
+        ; a character row to the bottom line of the previous one
+        xor     a
+        sub     e
+        ld      e,a
+        ld      a,#0x38
+        sbc     a,d
+        ld      d,a
+
+        ex      (sp),hl
+        pop     bc              ; bc = address of the last line
+        di
+        ld      sp,hl           ; sp = end of table
+        ld      h,b
+        ld      l,c
+        ld      b,9(ix)
+
+line$:
+        push    hl
+        ld      a,h
+        and     #0x38           ; top line of a character row?
+        jr      z,previous_row$
+        ld      a,h
+        sub     #8
+        ld      h,a
+        djnz    line$
+        jr      table_done$
+previous_row$:
+        add     hl,de
+        djnz    line$
+
+table_done$:
+        ld      sp,ix
+        ei
+done$:
+        pop     ix
+        ret
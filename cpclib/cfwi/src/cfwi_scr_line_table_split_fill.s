@@ -0,0 +1,51 @@
+.module cfwi_scr_line_table_split_fill
+
+; void cfwi_scr_line_table_split_fill (uint8_t table_page, uint8_t *first_line, uint8_t crtc_r1, uint8_t line_count);
+; Fill the low bytes of line addresses at table_page * 256 + y and the
+; high bytes one page further.
+; 20 NOPs per line (200 lines: about 4 ms), plus 10 per character row.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+_cfwi_scr_line_table_split_fill::
+        ld      hl,#2
+        add     hl,sp
+        ld      a,(hl)          ; table_page
+        inc     hl
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)          ; de = first_line
+        inc     hl
+        ld      c,(hl)
+        sla     c               ; c = bytes per character row = 2 * R1
+        inc     hl
+        ld      b,(hl)          ; b = line_count
+        ld      h,a
+        ld      l,#0
+
+        ld      a,b
+        or      a
+        ret     z
+
+line$:
+        ld      (hl),e
+        inc     h
+        ld      (hl),d
+        dec     h
+        inc     l
+
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        and     #0x38           ; wrapped past the bottom line of a character row?
+        jr      nz,next$
+        ld      a,d
+        sub     #0x40
+        ld      d,a
+        ld      a,e
+        add     a,c
+        ld      e,a
+        jr      nc,next$
+        inc     d
+next$:
+        djnz    line$
+        ret
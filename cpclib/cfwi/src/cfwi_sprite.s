@@ -0,0 +1,10 @@
+.module cfwi_sprite
+
+; State shared by the cfwi_sprite_* blitters.
+
+        .area _DATA
+
+_cfwi_sprite_screen::
+        .ds     2
+_cfwi_sprite_buffer::
+        .ds     2
@@ -0,0 +1,104 @@
+.module cfwi_sprite_opaque
+
+; void cfwi_sprite_opaque (const cfwi_sprite_t *sprite) __z88dk_fastcall;
+; Copy sprite data to cfwi_sprite_screen.
+; void cfwi_sprite_restore (const cfwi_sprite_t *sprite) __z88dk_fastcall;
+; Copy cfwi_sprite_buffer back to cfwi_sprite_screen.
+;
+; Assembly entries, screen address in DE instead of cfwi_sprite_screen:
+; cfwi_sprite_opaque_hl_de  HL = sprite
+; cfwi_sprite_restore_hl_de HL = sprite
+;
+; One LDI per byte, entering an unrolled block at the point that
+; matches the sprite width.  The byte count of the whole sprite is
+; kept in BC, so that the P/V flag of the last LDI of a line tells
+; whether the sprite is done, without any line counter.
+;
+; 5 NOPs per byte, 21 per line, 9 more per character row crossed,
+; about 100 per call.  Width at most 80 bytes.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+CHAR_ROW_BYTES = 0x50
+MAX_WIDTH = 80
+
+_cfwi_sprite_restore::
+        ld      de,(_cfwi_sprite_screen)
+cfwi_sprite_restore_hl_de::
+        push    ix
+        ld      bc,(_cfwi_sprite_buffer)
+        inc     hl
+        inc     hl
+        jr      copy
+
+_cfwi_sprite_opaque::
+        ld      de,(_cfwi_sprite_screen)
+cfwi_sprite_opaque_hl_de::
+        push    ix
+        ld      c,(hl)
+        inc     hl
+        ld      b,(hl)
+        inc     hl
+copy:
+        push    bc              ; source
+        push    de              ; screen
+        ld      e,(hl)          ; e = width
+        inc     hl
+        ld      a,(hl)          ; a = height
+
+        ; hl = width * height
+        ld      d,#0
+        ld      hl,#0
+        ld      b,#8
+multiply:
+        add     hl,hl
+        add     a,a
+        jr      nc,next_bit
+        add     hl,de
+next_bit:
+        djnz    multiply
+
+        ; ix = copy_end - 2 * width
+        xor     a
+        sub     e
+        ld      e,a
+        sbc     a,a
+        ld      d,a
+        ld      ix,#copy_end
+        add     ix,de
+        add     ix,de
+
+        ld      b,h
+        ld      c,l             ; bc = byte count
+        pop     de              ; de = screen
+        pop     hl              ; hl = source
+        ld      a,b
+        or      c
+        jp      z,done
+
+line:
+        push    de
+        jp      (ix)
+        .rept   MAX_WIDTH
+        ldi
+        .endm
+copy_end:
+        jp      po,last_line
+        pop     de
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        and     #0x38
+        jp      nz,line
+        ld      a,e
+        add     a,#CHAR_ROW_BYTES
+        ld      e,a
+        ld      a,d
+        adc     a,#0xC0
+        ld      d,a
+        jp      line
+
+last_line:
+        pop     de
+done:
+        pop     ix
+        ret
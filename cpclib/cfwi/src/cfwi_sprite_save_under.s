@@ -0,0 +1,85 @@
+.module cfwi_sprite_save_under
+
+; void cfwi_sprite_save_under (const cfwi_sprite_t *sprite) __z88dk_fastcall;
+; Copy the screen area that sprite will cover at cfwi_sprite_screen
+; to cfwi_sprite_buffer, which must hold width * height bytes.
+;
+; Assembly entry, screen address in DE instead of cfwi_sprite_screen:
+; cfwi_sprite_save_under_hl_de HL = sprite
+;
+; Same technique and cost as cfwi_sprite_opaque.
+; 5 NOPs per byte, 21 per line, 9 more per character row crossed,
+; about 100 per call.  Width at most 80 bytes.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+CHAR_ROW_BYTES = 0x50
+MAX_WIDTH = 80
+
+_cfwi_sprite_save_under::
+        ld      de,(_cfwi_sprite_screen)
+cfwi_sprite_save_under_hl_de::
+        push    ix
+        push    de              ; screen
+        inc     hl
+        inc     hl
+        ld      e,(hl)          ; e = width
+        inc     hl
+        ld      a,(hl)          ; a = height
+
+        ; hl = width * height
+        ld      d,#0
+        ld      hl,#0
+        ld      b,#8
+multiply:
+        add     hl,hl
+        add     a,a
+        jr      nc,next_bit
+        add     hl,de
+next_bit:
+        djnz    multiply
+
+        ; ix = copy_end - 2 * width
+        xor     a
+        sub     e
+        ld      e,a
+        sbc     a,a
+        ld      d,a
+        ld      ix,#copy_end
+        add     ix,de
+        add     ix,de
+
+        ld      b,h
+        ld      c,l             ; bc = byte count
+        pop     hl              ; hl = screen
+        ld      de,(_cfwi_sprite_buffer)
+        ld      a,b
+        or      c
+        jp      z,done
+
+line:
+        push    hl
+        jp      (ix)
+        .rept   MAX_WIDTH
+        ldi
+        .endm
+copy_end:
+        jp      po,last_line
+        pop     hl
+        ld      a,h
+        add     a,#8
+        ld      h,a
+        and     #0x38
+        jp      nz,line
+        ld      a,l
+        add     a,#CHAR_ROW_BYTES
+        ld      l,a
+        ld      a,h
+        adc     a,#0xC0
+        ld      h,a
+        jp      line
+
+last_line:
+        pop     hl
+done:
+        pop     ix
+        ret
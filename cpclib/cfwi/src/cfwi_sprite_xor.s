@@ -0,0 +1,86 @@
+.module cfwi_sprite_xor
+
+; void cfwi_sprite_xor (const cfwi_sprite_t *sprite) __z88dk_fastcall;
+; Exclusive-or sprite data onto cfwi_sprite_screen.  Drawing the same
+; sprite twice at the same place restores the screen.
+;
+; Assembly entry, screen address in DE instead of cfwi_sprite_screen:
+; cfwi_sprite_xor_hl_de HL = sprite
+;
+; Each line enters an unrolled block at the point that matches the
+; sprite width.
+;
+; 10 NOPs per byte, 22 per line, 9 more per character row crossed,
+; about 60 per call.  Width at most 80 bytes.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+CHAR_ROW_BYTES = 0x50
+MAX_WIDTH = 80
+
+_cfwi_sprite_xor::
+        ld      de,(_cfwi_sprite_screen)
+cfwi_sprite_xor_hl_de::
+        push    ix
+        ld      c,(hl)
+        inc     hl
+        ld      b,(hl)
+        inc     hl
+        push    bc              ; data
+        push    de              ; screen
+        ld      c,(hl)          ; c = width
+        inc     hl
+        ld      b,(hl)          ; b = height
+
+        ; ix = xor_end - 5 * width
+        ld      l,c
+        ld      h,#0
+        ld      d,h
+        ld      e,l
+        add     hl,hl
+        add     hl,hl
+        add     hl,de           ; hl = 5 * width
+        xor     a
+        sub     l
+        ld      e,a
+        sbc     a,a
+        sub     h
+        ld      d,a
+        ld      ix,#xor_end
+        add     ix,de
+
+        pop     de              ; de = screen
+        pop     hl              ; hl = data
+        ld      a,b
+        or      a
+        jp      z,done
+
+line:
+        push    de
+        jp      (ix)
+        .rept   MAX_WIDTH
+        ld      a,(de)
+        xor     (hl)
+        ld      (de),a
+        inc     hl
+        inc     de
+        .endm
+xor_end:
+        pop     de
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        and     #0x38
+        jr      nz,next_line
+        ld      a,e
+        add     a,#CHAR_ROW_BYTES
+        ld      e,a
+        ld      a,d
+        adc     a,#0xC0
+        ld      d,a
+next_line:
+        dec     b
+        jp      nz,line
+
+done:
+        pop     ix
+        ret
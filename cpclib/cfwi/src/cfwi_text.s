@@ -0,0 +1,286 @@
+.module cfwi_text
+
+; Text renderer drawing glyphs of a font expanded once into screen
+; bytes for a given mode, pen and paper.
+; WARNING DONE BUT UNTESTED, MIGHT NOT WORK
+
+        .area _DATA
+
+_cfwi_text_screen::
+        .ds     2
+font:
+        .ds     2
+first_char:
+        .ds     1
+char_count:                     ; must follow first_char
+        .ds     1
+bytes_per_row:
+        .ds     1
+glyph_shift:
+        .ds     1
+glyph_routine:
+        .ds     2
+mask_table:
+        .ds     2
+pen_byte:
+        .ds     1
+paper_byte:
+        .ds     1
+matrix:
+        .ds     8
+
+        .area _CODE
+
+; Pixel masks of a byte, left pixel first, zero terminated.
+masks_mode0:
+        .byte   0xAA, 0x55, 0
+masks_mode1:
+        .byte   0x88, 0x44, 0x22, 0x11, 0
+masks_mode2:
+        .byte   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, 0
+
+; Glyph routine and mask table of each mode.
+modes:
+        .word   glyph_mode0, masks_mode0
+        .word   glyph_mode1, masks_mode1
+        .word   glyph_mode2, masks_mode2
+
+; void cfwi_text_setup (uint8_t *font_buffer, uint8_t mode, uint8_t pen, uint8_t paper, uint8_t first_char, uint8_t char_count);
+; Reads each matrix with TXT GET MATRIX, from the lower ROM when it is
+; there, so this routine must not be linked below 0x4000.
+_cfwi_text_setup::
+        push    ix
+        ld      ix,#0
+        add     ix,sp
+
+        ld      l,4(ix)
+        ld      h,5(ix)
+        ld      (font),hl
+        ld      a,9(ix)
+        ld      (first_char),a
+        ld      a,10(ix)
+        ld      (char_count),a
+
+        ; glyph size = 1 << (5 - mode), bytes per row = 4 >> mode
+        ld      c,6(ix)
+        ld      a,#5
+        sub     c
+        ld      (glyph_shift),a
+        ld      a,#4
+        inc     c
+        jr      bytes_per_row_test
+bytes_per_row_shift:
+        srl     a
+bytes_per_row_test:
+        dec     c
+        jr      nz,bytes_per_row_shift
+        ld      (bytes_per_row),a
+
+        ld      a,6(ix)
+        add     a,a
+        add     a,a
+        ld      e,a
+        ld      d,#0
+        ld      hl,#modes
+        add     hl,de
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        inc     hl
+        ld      (glyph_routine),de
+        ld      e,(hl)
+        inc     hl
+        ld      d,(hl)
+        ld      (mask_table),de
+
+        ld      a,6(ix)
+        ld      l,7(ix)
+        call    cfwi_pen_byte
+        ld      (pen_byte),a
+        ld      a,6(ix)
+        ld      l,8(ix)
+        call    cfwi_pen_byte
+        ld      (paper_byte),a
+
+        ld      c,9(ix)         ; c = character
+        ld      b,10(ix)        ; b = count
+        ld      l,4(ix)
+        ld      h,5(ix)
+        push    hl
+        pop     ix              ; ix = output
+        ld      a,b
+        or      a
+        jr      z,setup_done
+
+char:
+        push    bc
+        ld      a,c
+        call    0xBBA5          ; TXT GET MATRIX
+        ld      de,#matrix
+        ld      bc,#8
+        jr      c,copy_from_ram
+        call    0xB906          ; KL L ROM ENABLE
+        ldir
+        call    0xB90C          ; KL ROM RESTORE
+        jr      copied
+copy_from_ram:
+        ldir
+copied:
+        ld      hl,#matrix
+        ld      b,#8
+row:
+        ld      c,(hl)
+        inc     hl
+        push    bc
+        push    hl
+        call    expand_row
+        pop     hl
+        pop     bc
+        djnz    row
+        pop     bc
+        inc     c
+        djnz    char
+
+setup_done:
+        pop     ix
+        ret
+
+; Expand one matrix row to bytes_per_row screen bytes.
+; In: c = matrix row, ix = output.  Out: ix advanced.
+; Corrupts af, bc, de, hl.
+expand_row:
+        ld      a,(bytes_per_row)
+        ld      b,a
+out_byte:
+        ld      hl,(mask_table)
+        ld      e,#0
+pixel:
+        ld      a,(hl)
+        or      a
+        jr      z,byte_done
+        inc     hl
+        ld      d,a
+        sla     c
+        ld      a,(paper_byte)
+        jr      nc,ink_found
+        ld      a,(pen_byte)
+ink_found:
+        and     d
+        or      e
+        ld      e,a
+        jr      pixel
+byte_done:
+        ld      0(ix),e
+        inc     ix
+        djnz    out_byte
+        ret
+
+; void cfwi_text_draw_str0 (const char *s) __z88dk_fastcall;
+_cfwi_text_draw_str0::
+        push    ix
+        ld      ix,(glyph_routine)
+        ld      de,(_cfwi_text_screen)
+next_char:
+        ld      a,(hl)
+        or      a
+        jr      z,str_done
+        inc     hl
+        push    hl
+        call    draw_glyph
+        pop     hl
+        jr      next_char
+str_done:
+        ld      (_cfwi_text_screen),de
+        pop     ix
+        ret
+
+; void cfwi_text_draw_char (char c) __z88dk_fastcall;
+_cfwi_text_draw_char::
+        push    ix
+        ld      ix,(glyph_routine)
+        ld      de,(_cfwi_text_screen)
+        ld      a,l
+        call    draw_glyph
+        ld      (_cfwi_text_screen),de
+        pop     ix
+        ret
+
+; Draw a character and advance to the next character cell.
+; Characters that were not expanded only advance.
+; In: a = character, de = screen, ix = glyph routine.
+; Out: de advanced.  Corrupts af, bc, hl.
+draw_glyph:
+        ld      hl,#first_char
+        sub     (hl)
+        inc     hl
+        cp      (hl)            ; char_count
+        jr      nc,advance
+        push    de
+        ld      l,a
+        ld      h,#0
+        ld      a,(glyph_shift)
+        ld      b,a
+glyph_offset:
+        add     hl,hl
+        djnz    glyph_offset
+        ld      bc,(font)
+        add     hl,bc
+        call    call_glyph
+        pop     de
+advance:
+        ld      a,(bytes_per_row)
+        add     a,e
+        ld      e,a
+        adc     a,d
+        sub     e
+        ld      d,a
+        ret
+
+call_glyph:
+        jp      (ix)
+
+; Copy a glyph to screen, one row per screen line of a character row.
+; In: hl = glyph, de = top line.  Corrupts af, bc, de, hl.
+glyph_mode0:
+        .rept   7
+        push    de
+        ldi
+        ldi
+        ldi
+        ldi
+        pop     de
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        .endm
+        ldi
+        ldi
+        ldi
+        ldi
+        ret
+
+glyph_mode1:
+        .rept   7
+        push    de
+        ldi
+        ldi
+        pop     de
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        .endm
+        ldi
+        ldi
+        ret
+
+glyph_mode2:
+        .rept   7
+        push    de
+        ldi
+        pop     de
+        ld      a,d
+        add     a,#8
+        ld      d,a
+        .endm
+        ldi
+        ret
@@ -0,0 +1,20 @@
+.module fw_kl_add_ticker
+
+_fw_kl_add_ticker::
+        ld      hl,#2
+        add     hl,sp
+        ld      a,(hl)		; tick block address, LSB
+        inc     hl
+        ld      d,(hl)		; tick block address, MSB
+        push    de
+        inc     hl
+        ld      e,(hl)		; initial count, LSB
+        inc     hl
+        ld      d,(hl)		; initial count, MSB
+        inc     hl
+        ld      c,(hl)		; reload count, LSB
+        inc     hl
+        ld      b,(hl)		; reload count, MSB
+        pop     hl
+        ld      l,a
+        jp      0xBCE9  ; KL ADD TICKER
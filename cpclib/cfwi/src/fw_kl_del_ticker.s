@@ -0,0 +1,8 @@
+.module fw_kl_del_ticker
+
+_fw_kl_del_ticker::
+        call    0xBCEC  ; KL DEL TICKER
+        ex      de,hl
+        ret     c
+        ld      hl,#0
+        ret
@@ -0,0 +1,19 @@
+.module fw_kl_new_fast_ticker
+
+_fw_kl_new_fast_ticker::
+        ld      hl,#2
+        add     hl,sp
+        ld      e,(hl)		; block address, LSB
+        inc     hl
+        ld      d,(hl)		; block address, MSB
+        inc     hl
+        ld      b,(hl)		; event class
+        inc     hl
+        ld      c,(hl)		; ROM select address
+        inc     hl
+        ld      a,(hl)		; event routine address, LSB
+        inc     hl
+        ld      h,(hl)		; event routine address, MSB
+        ld      l,a
+        ex      de,hl
+        jp      0xBCE0  ; KL NEW FAST TICKER
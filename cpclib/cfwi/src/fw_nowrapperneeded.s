@@ -97,6 +97,13 @@
 	_fw_sound_reset == 0xBCA7
 	_fw_sound_continue == 0xBCB9
 
+	;; void function(block *) __z88dk_fastcall;
+
+	_fw_kl_add_frame_fly == 0xBCDA
+	_fw_kl_del_frame_fly == 0xBCDD
+	_fw_kl_add_fast_ticker == 0xBCE3
+	_fw_kl_del_fast_ticker == 0xBCE6
+
 	;; long int function (void);
 
 	_fw_kl_time_please == 0xBD0D
@@ -0,0 +1,37 @@
+#include "stdint.h"
+#include "cfwi/cfwi.h"
+
+uint32_t plot_with_firmware( void );
+uint32_t plot_with_fast_plot( void );
+uint16_t screen_checksum( void );
+void print_uint8( uint8_t n );
+
+void
+main()
+{
+        uint32_t firmware_time, fast_time;
+        uint16_t firmware_checksum, fast_checksum;
+
+        fw_mc_send_printer( '0' );
+
+        firmware_time = plot_with_firmware();
+        firmware_checksum = screen_checksum();
+
+        fast_time = plot_with_fast_plot();
+        fast_checksum = screen_checksum();
+
+        fw_mc_send_printer( '1' );
+
+        /* Both must draw exactly the same pixels. */
+        fw_mc_send_printer( ( firmware_checksum == fast_checksum ) ? 0 : 1 );
+
+        /* Timings depend on the emulator, only a verdict is logged. */
+        fw_mc_send_printer( ( fast_time * 3 <= firmware_time ) ? 'F' : 'S' );
+
+        cfwi_txt_str0_output( "Speedup x" );
+        print_uint8( ( fast_time != 0 ) ? ( uint8_t ) ( firmware_time / fast_time ) : 0 );
+
+        fw_mc_send_printer( '2' );
+        fw_mc_wait_flyback();
+        fw_mc_wait_flyback();
+}
@@ -0,0 +1,85 @@
+#include "cfwi/cfwi.h"
+#include "stdint.h"
+
+/* Same pattern as the gra_plot_absolute test.  Firmware coordinates
+   (2x+1, 2y+1) are pixel (x, 199-y) in mode 1, lines beyond the top
+   of the screen are clipped. */
+
+uint32_t plot_with_firmware()
+{
+        static unsigned char x, y;
+        uint32_t time_before;
+
+        fw_scr_set_mode( 1 );
+        fw_gra_set_pen( 1 );
+
+        time_before = fw_kl_time_please();
+
+        for ( x = 0; x < 255; x++ )
+        {
+                for ( y = 0; y < 255; y++ )
+                {
+                        if ( ( x ^ y ) > x )
+                        {
+                                fw_gra_plot_absolute( 2 * x + 1, 2 * y + 1 );
+                        }
+                }
+        }
+
+        return fw_kl_time_please() - time_before;
+}
+
+uint32_t plot_with_fast_plot()
+{
+        static unsigned char x, y;
+        uint32_t time_before;
+
+        fw_scr_set_mode( 1 );
+
+        /* Setup is part of the measured time. */
+        time_before = fw_kl_time_please();
+
+        cfwi_scr_line_table_fill( cfwi_scr_line_table, ( uint8_t * ) 0xC000, 40, CFWI_SCR_LINE_TABLE_LINES );
+        cfwi_fast_plot_setup( 1, cfwi_scr_line_table );
+
+        for ( x = 0; x < 255; x++ )
+        {
+                for ( y = 0; y < 255; y++ )
+                {
+                        if ( ( x ^ y ) > x )
+                        {
+                                cfwi_fast_plot_set_clipped( x, 199 - y );
+                        }
+                }
+        }
+
+        return fw_kl_time_please() - time_before;
+}
+
+uint16_t screen_checksum()
+{
+        uint8_t *p = ( uint8_t * ) 0xC000;
+        uint16_t sum = 0;
+
+        do
+        {
+                sum = ( ( sum << 1 ) | ( sum >> 15 ) ) ^ *p;
+                p++;
+        }
+        while ( p != 0 );
+
+        return sum;
+}
+
+void print_uint8( uint8_t n )
+{
+        if ( n >= 100 )
+        {
+                fw_txt_output( '0' + n / 100 );
+        }
+        if ( n >= 10 )
+        {
+                fw_txt_output( '0' + ( n / 10 ) % 10 );
+        }
+        fw_txt_output( '0' + n % 10 );
+}
@@ -1,6 +1,6 @@
 #include "stdint.h"
 #include "cfwi/cfwi.h"
-#include "random_with_8bit_lfsr.h"
+#include "cdtc/random.h"
 #include "setborder.h"
 
 uint16_t random_statex = 0xcafe;
@@ -96,11 +96,11 @@ uint8_t perform_test()
                 uint8_t star_count = 40;
                 while (star_count>0)
                 {
-                        uint8_t x = random_with_16bit_lfsr(&random_statex) & 0x3f;
+                        uint8_t x = cdtc_random_lfsr16__fastcall(&random_statex) & 0x3f;
                         uint8_t y;
                         //fw_mc_send_printer(y);
                         if (x>39) continue;
-                        y = random_with_16bit_lfsr(&random_statey) & 0x1f;
+                        y = cdtc_random_lfsr16__fastcall(&random_statey) & 0x1f;
                         if (y>24) continue;
 
                         fw_txt_set_cursor(y, x);
@@ -114,7 +114,7 @@ uint8_t perform_test()
 
                 while ( offset != 0 )
                 {
-                        uint8_t n = random_with_16bit_lfsr( &random_statex );
+                        uint8_t n = cdtc_random_lfsr16__fastcall( &random_statex );
                         fw_mc_wait_flyback();
                         fw_scr_set_offset( offset );
                         fw_txt_set_cursor__fastcall( 0x230c );
@@ -132,7 +132,7 @@ uint8_t perform_test()
                         fw_txt_set_column( 1 );
                         /*fw_txt_set_pen( 1 );*/
                         /*{
-                                uint8_t n = random_with_16bit_lfsr(&random_statex);
+                                uint8_t n = cdtc_random_lfsr16__fastcall(&random_statex);
                                 if (n > 249)
                                 {
                                         fw_txt_set_cursor__fastcall(0x2718);
@@ -0,0 +1,360 @@
+/* Statistical quality report of the pseudo-random number generators
+ * of cpclib/cdtc/include/cdtc/random.h, run on the host.
+ *
+ * Each generator is modelled here bit for bit as the Z80 code in
+ * cpclib/cdtc/asminclude/cdtc/random.macros.s computes it, then its
+ * output is checked with chi-square tests on values, consecutive pairs
+ * of high bits and triples of low bits.  The cheapest generator
+ * passing all tests is picked as default for each use: CDTC_RANDOM8
+ * and CDTC_RANDOM16.
+ *
+ * Build and run: make -C documentation-for-maintainers/random_quality
+ * The result is in README.md next to this file.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdbool.h>
+
+#define SAMPLES (1 << 22)
+
+/* Generators: state, then one output per call. */
+
+static uint8_t lfsr8_state;
+static uint16_t lfsr16_state;
+static uint16_t xorshift16_state;
+static uint8_t table[256];
+static uint8_t table_index;
+static uint32_t sdcc_rand_state;
+
+static uint8_t lfsr8(void)
+{
+        uint8_t carry = lfsr8_state & 1;
+
+        lfsr8_state >>= 1;
+        if (carry)
+        {
+                lfsr8_state ^= 0xB8;
+        }
+        return lfsr8_state;
+}
+
+static uint16_t lfsr16(void)
+{
+        uint8_t carry = lfsr16_state & 1;
+
+        lfsr16_state >>= 1;
+        if (carry)
+        {
+                lfsr16_state ^= 0xB400;
+        }
+        return lfsr16_state;
+}
+
+static uint16_t xorshift16(void)
+{
+        xorshift16_state ^= xorshift16_state << 7;
+        xorshift16_state ^= xorshift16_state >> 9;
+        xorshift16_state ^= xorshift16_state << 8;
+        return xorshift16_state;
+}
+
+static uint8_t table8(void)
+{
+        uint8_t n = ++table_index;
+
+        table[n] = table[(uint8_t)(n - 24)] + table[(uint8_t)(n - 55)];
+        return table[n];
+}
+
+/* Same as cdtc_random_table_seed. */
+static void table8_seed(uint16_t seed)
+{
+        xorshift16_state = seed ? seed : 1;
+        for (int i = 0; i < 256; i++)
+        {
+                table[i] = xorshift16() >> 8;
+        }
+        table[0] |= 1;
+        table_index = 0;
+}
+
+/* What SDCC's rand() computes, for comparison. */
+static uint16_t sdcc_rand(void)
+{
+        sdcc_rand_state = sdcc_rand_state * 1103515245UL + 12345;
+        return (sdcc_rand_state >> 16) & 0x7FFF;
+}
+
+/* Outputs as used by callers. */
+
+static uint16_t out_lfsr8(void)
+{
+        return lfsr8();
+}
+
+static uint16_t out_lfsr16_low(void)
+{
+        return lfsr16() & 0xFF;
+}
+
+static uint16_t out_lfsr16_8_steps(void)
+{
+        for (int i = 0; i < 7; i++)
+        {
+                lfsr16();
+        }
+        return lfsr16() & 0xFF;
+}
+
+static uint16_t out_xorshift16_low(void)
+{
+        return xorshift16() & 0xFF;
+}
+
+static uint16_t out_xorshift16_high(void)
+{
+        return xorshift16() >> 8;
+}
+
+static uint16_t out_table8(void)
+{
+        return table8();
+}
+
+static uint16_t out_sdcc_rand_low(void)
+{
+        return sdcc_rand() & 0xFF;
+}
+
+static uint16_t out_lfsr16(void)
+{
+        return lfsr16();
+}
+
+static uint16_t out_xorshift16(void)
+{
+        return xorshift16();
+}
+
+static uint16_t out_table16(void)
+{
+        uint8_t low = table8();
+
+        return table8() << 8 | low;
+}
+
+static uint16_t out_sdcc_rand(void)
+{
+        return sdcc_rand() << 1 | (sdcc_rand() >> 14 & 1);
+}
+
+struct generator
+{
+        const char *name;
+        const char *function;
+        void (*seed)(void);
+        uint16_t (*next)(void);
+        /* NOPs per value, call and return included */
+        int cost;
+        /* 0 if more than SAMPLES */
+        unsigned long period;
+        bool word;
+};
+
+static void seed_all(void)
+{
+        lfsr8_state = 1;
+        lfsr16_state = 1;
+        xorshift16_state = 1;
+        sdcc_rand_state = 1;
+        table8_seed(1);
+}
+
+static const struct generator generators[] = {
+        {"lfsr8", "cdtc_random_lfsr8__fastcall", seed_all, out_lfsr8, 18, 255, false},
+        {"lfsr16 low byte", "cdtc_random_lfsr16__fastcall", seed_all, out_lfsr16_low, 31, 65535, false},
+        {"lfsr16 8 steps, low byte", "8 x CDTC_RANDOM_LFSR16", seed_all, out_lfsr16_8_steps, 85, 65535, false},
+        {"xorshift16 low byte", "cdtc_random_xorshift16__fastcall", seed_all, out_xorshift16_low, 37, 65535, false},
+        {"xorshift16 high byte", "cdtc_random_xorshift16__fastcall", seed_all, out_xorshift16_high, 37, 65535, false},
+        {"table8", "cdtc_random_table8", seed_all, out_table8, 34, 0, false},
+        {"SDCC rand low byte", "rand", seed_all, out_sdcc_rand_low, 1500, 0, false},
+        {"lfsr16", "cdtc_random_lfsr16__fastcall", seed_all, out_lfsr16, 31, 65535, true},
+        {"xorshift16", "cdtc_random_xorshift16__fastcall", seed_all, out_xorshift16, 37, 65535, true},
+        {"table8, 2 bytes", "cdtc_random_table16", seed_all, out_table16, 61, 0, true},
+        {"SDCC rand, 2 calls", "rand", seed_all, out_sdcc_rand, 3000, 0, true},
+};
+
+#define GENERATOR_COUNT (sizeof(generators) / sizeof(generators[0]))
+
+static uint32_t counts[1 << 16];
+
+/* Standard score of a chi-square statistic, close to 0 for a good
+ * generator, beyond 3 either way means failed.  Far below 0 means
+ * values are spread more evenly than by chance. */
+static double chi_square_z(const uint32_t *cells, unsigned long cell_count,
+                           unsigned long samples)
+{
+        double expected = (double)samples / cell_count;
+        double chi2 = 0;
+
+        for (unsigned long i = 0; i < cell_count; i++)
+        {
+                double d = cells[i] - expected;
+                chi2 += d * d / expected;
+        }
+
+        return (chi2 - (cell_count - 1)) / sqrt(2.0 * (cell_count - 1));
+}
+
+/* Tests use at most one period, since values repeat after. */
+static bool full_period(const struct generator *g)
+{
+        return g->period && g->period < SAMPLES;
+}
+
+static unsigned long samples(const struct generator *g)
+{
+        return full_period(g) ? g->period : SAMPLES;
+}
+
+/* Byte seen by tests: the value, or the high byte of 16-bit values. */
+static uint8_t byte(const struct generator *g, uint16_t v)
+{
+        return g->word ? v >> 8 : v;
+}
+
+/* Values. */
+static double test_values(const struct generator *g)
+{
+        unsigned long n = samples(g);
+
+        memset(counts, 0, sizeof(counts));
+        g->seed();
+        for (unsigned long i = 0; i < n; i++)
+        {
+                counts[byte(g, g->next())]++;
+        }
+        return chi_square_z(counts, 256, n);
+}
+
+/* Consecutive pairs of the high 6 bits. */
+static double test_pairs(const struct generator *g)
+{
+        unsigned long n = samples(g);
+
+        memset(counts, 0, sizeof(counts));
+        g->seed();
+        uint8_t a = byte(g, g->next()) >> 2;
+        for (unsigned long i = 0; i < n; i++)
+        {
+                uint8_t b = byte(g, g->next()) >> 2;
+                counts[a << 6 | b]++;
+                a = b;
+        }
+        return chi_square_z(counts, 1 << 12, n);
+}
+
+/* Consecutive triples of the low 4 bits, as used for example by
+ * "random() & 15" to pick a direction. */
+static double test_triples(const struct generator *g)
+{
+        unsigned long n = samples(g);
+
+        memset(counts, 0, sizeof(counts));
+        g->seed();
+        uint8_t a = g->next() & 15;
+        uint8_t b = g->next() & 15;
+        for (unsigned long i = 0; i < n; i++)
+        {
+                uint8_t c = g->next() & 15;
+                counts[a << 8 | b << 4 | c]++;
+                a = b;
+                b = c;
+        }
+        return chi_square_z(counts, 1 << 12, n);
+}
+
+static bool passed(double z)
+{
+        return fabs(z) < 3;
+}
+
+/* Over exactly one period, a generator gives each state once, so
+ * values spread too evenly by construction: the test cannot tell,
+ * which is not a pass either. */
+static const char *verdict(const struct generator *g, double z)
+{
+        if (passed(z))
+        {
+                return "ok";
+        }
+        return z < 0 && full_period(g) ? "n/a" : "FAIL";
+}
+
+static void report(bool word)
+{
+        const struct generator *best = NULL;
+
+        printf("| generator | function | NOPs | period | values | pairs | low bits triples |\n");
+        printf("|---|---|---|---|---|---|---|\n");
+
+        for (size_t i = 0; i < GENERATOR_COUNT; i++)
+        {
+                const struct generator *g = &generators[i];
+                char period[32];
+
+                if (g->word != word)
+                {
+                        continue;
+                }
+
+                double values = test_values(g);
+                double pairs = test_pairs(g);
+                double triples = test_triples(g);
+
+                if (g->period)
+                {
+                        snprintf(period, sizeof(period), "%lu", g->period);
+                }
+                else
+                {
+                        snprintf(period, sizeof(period), "> 2^22");
+                }
+
+                printf("| %s | %s | %d | %s | %.1f %s | %.1f %s | %.1f %s |\n",
+                       g->name, g->function, g->cost, period,
+                       values, verdict(g, values), pairs, verdict(g, pairs),
+                       triples, verdict(g, triples));
+
+                if (passed(values) && passed(pairs) && passed(triples) &&
+                    (best == NULL || g->cost < best->cost))
+                {
+                        best = g;
+                }
+        }
+
+        printf("\nDefault: %s (%s).\n\n", best ? best->name : "none",
+               best ? best->function : "-");
+}
+
+int main(void)
+{
+        printf("Standard scores of chi-square tests over %d values or one "
+               "period, failed beyond 3 either way, n/a below -3 over one "
+               "period.\n\n",
+               SAMPLES);
+
+        printf("### 8-bit values (CDTC_RANDOM8)\n\n");
+        report(false);
+
+        printf("### 16-bit values (CDTC_RANDOM16), values and pairs tests "
+               "on high bytes\n\n");
+        report(true);
+
+        return 0;
+}
@@ -0,0 +1,320 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include <stdbool.h>
+
+const char *argp_program_version = "cdtc_tablegen 0.1";
+const char *argp_program_bug_address = "<stephane_cpcitor@gourichon.org>";
+
+#define area_name_default "_CDTC_ALIGNED"
+
+static char doc[] =
+        "\n"
+        "cdtc_tablegen by Stéphane Gourichon (cpcitor).\n"
+        "\n"
+        "## Summary: what it does\n\n"
+        "Generate fixed-point math tables for an Amstrad CPC program, "
+        "expressed as assembly source code, so that sin, cos, atan2, "
+        "reciprocal and square root need neither floating point nor "
+        "computation at run time.  Tables are read through the accessors "
+        "of cpclib/cdtc/include/cdtc/fixed_tables.h.\n"
+        "\n"
+        "## Output\n\n"
+        "Each table starts on a 256-byte page boundary in linker area "
+        "_CDTC_ALIGNED (see CDTC_ALIGNED_LOC in sdcc-project.Makefile).  "
+        "16-bit tables are split in a page of low bytes followed by a page "
+        "of high bytes, so that a lookup is 'ld h,page ; ld l,index' "
+        "without any 16-bit arithmetic.\n"
+        "\n"
+        "* sin: <size> entries per full turn, signed 8.8, "
+        "round(256 * sin(2 * pi * a / size)).  Symbols _cdtc_sin_low, "
+        "_cdtc_sin_high.  cos uses the same table a quarter turn later.\n"
+        "\n"
+        "* atan: <size> + 1 angles for ratios i / size from 0 to 1, in "
+        "units of the sin table, 8 bits.  Symbol _cdtc_atan_octant.\n"
+        "\n"
+        "* recip: <size> entries, unsigned 0.16, min(65535, round(65536 / "
+        "i)), 65535 for i = 0.  Symbols _cdtc_recip_low, _cdtc_recip_high.\n"
+        "\n"
+        "* sqrt: <size> entries, unsigned 8.8, round(256 * sqrt(i)).  "
+        "Symbols _cdtc_sqrt_low, _cdtc_sqrt_high.\n"
+        "\n"
+        "Sizes are exported as assembler constants cdtc_<table>_size.";
+
+static struct argp_option options[] = {
+        {0, 0, 0, 0, "Input/output", 1},
+        {"output", 'o', "<output_filename.s>", 0,
+         "Path where the output file will be written in assembly source "
+         "format.",
+         1},
+        {"area", 'a', "<area_name>", 0,
+         "Optional.  Linker area of the tables.  Default is "
+         "'" area_name_default "'.",
+         1},
+        {0, 0, 0, 0, "Tables", 2},
+        {"sin", 's', 0, 0, "Generate the sin/cos table.", 2},
+        {"atan", 't', 0, 0, "Generate the atan octant table.", 2},
+        {"recip", 'r', 0, 0, "Generate the reciprocal table.", 2},
+        {"sqrt", 'q', 0, 0, "Generate the square root table.", 2},
+        {0, 0, 0, 0, "Sizes", 3},
+        {"sin_size", 1, "<64> or <128> or <256>", 0,
+         "Optional.  Angles per full turn.  Default is 256.", 3},
+        {"atan_size", 2, "<16> to <128>", 0,
+         "Optional.  Ratio steps in an octant, a power of two.  Default is "
+         "128.  The table has one more entry.",
+         3},
+        {"recip_size", 3, "<2> to <256>", 0,
+         "Optional.  Number of entries.  Default is 256.", 3},
+        {"sqrt_size", 4, "<2> to <256>", 0,
+         "Optional.  Number of entries.  Default is 256.", 3},
+        {0}};
+
+struct arguments
+{
+        char *output_file;
+        char *area_name;
+        bool sin;
+        bool atan;
+        bool recip;
+        bool sqrt;
+        unsigned int sin_size;
+        unsigned int atan_size;
+        unsigned int recip_size;
+        unsigned int sqrt_size;
+};
+
+static bool is_power_of_two(unsigned int n)
+{
+        return n != 0 && (n & (n - 1)) == 0;
+}
+
+/* Parse a single option. */
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+        struct arguments *arguments = state->input;
+
+        char *reason = NULL;
+
+        switch (key)
+        {
+        case 'o':
+                arguments->output_file = arg;
+                break;
+        case 'a':
+                arguments->area_name = arg;
+                break;
+        case 's':
+                arguments->sin = true;
+                break;
+        case 't':
+                arguments->atan = true;
+                break;
+        case 'r':
+                arguments->recip = true;
+                break;
+        case 'q':
+                arguments->sqrt = true;
+                break;
+        case 1:
+                arguments->sin_size = atoi(arg);
+                if (arguments->sin_size != 64 && arguments->sin_size != 128 &&
+                    arguments->sin_size != 256)
+                {
+                        reason = "sin size must be 64, 128 or 256";
+                        goto invalid;
+                }
+                break;
+        case 2:
+                arguments->atan_size = atoi(arg);
+                if (!is_power_of_two(arguments->atan_size) ||
+                    arguments->atan_size < 16 || arguments->atan_size > 128)
+                {
+                        reason = "atan size must be a power of two from 16 "
+                                 "to 128";
+                        goto invalid;
+                }
+                break;
+        case 3:
+                arguments->recip_size = atoi(arg);
+                if (arguments->recip_size < 2 || arguments->recip_size > 256)
+                {
+                        reason = "recip size must be from 2 to 256";
+                        goto invalid;
+                }
+                break;
+        case 4:
+                arguments->sqrt_size = atoi(arg);
+                if (arguments->sqrt_size < 2 || arguments->sqrt_size > 256)
+                {
+                        reason = "sqrt size must be from 2 to 256";
+                        goto invalid;
+                }
+                break;
+        case ARGP_KEY_ARG:
+                reason = "stray argument";
+                goto invalid;
+        case ARGP_KEY_END:
+                if (arguments->output_file == NULL)
+                {
+                        argp_error(state, "missing --output");
+                }
+                break;
+        default:
+                return ARGP_ERR_UNKNOWN;
+        }
+        return 0;
+
+invalid:
+        argp_error(state, "%s: %s", reason, arg);
+        return EINVAL;
+}
+
+static struct argp argp = {options, parse_opt, 0 /* args_doc */, doc, 0, 0, 0};
+
+/* Write count bytes, 12 per line, from a page boundary. */
+static void write_bytes(FILE *output_file, const char *symbol_name,
+                        const uint8_t *bytes, size_t count)
+{
+        fprintf(output_file, "\n\t.bndry 256\n_%s::", symbol_name);
+
+        for (size_t i = 0; i < count; i++)
+        {
+                fprintf(output_file, "%s0x%02x",
+                        i % 12 == 0 ? "\n\t.byte " : ", ", bytes[i]);
+        }
+        fprintf(output_file, "\n");
+}
+
+/* Write a 16-bit table as a page of low bytes then a page of high
+ * bytes. */
+static void write_split_table(FILE *output_file, const char *name,
+                              const int32_t *values, size_t count)
+{
+        uint8_t low[256];
+        uint8_t high[256];
+        char symbol_name[64];
+
+        for (size_t i = 0; i < count; i++)
+        {
+                low[i] = values[i] & 0xff;
+                high[i] = (values[i] >> 8) & 0xff;
+        }
+
+        snprintf(symbol_name, sizeof(symbol_name), "cdtc_%s_low", name);
+        write_bytes(output_file, symbol_name, low, count);
+        snprintf(symbol_name, sizeof(symbol_name), "cdtc_%s_high", name);
+        write_bytes(output_file, symbol_name, high, count);
+}
+
+static void write_sin(FILE *output_file, unsigned int size)
+{
+        int32_t values[256];
+
+        for (unsigned int a = 0; a < size; a++)
+        {
+                values[a] = lround(256.0 * sin(2.0 * M_PI * a / size));
+        }
+
+        fprintf(output_file, "\ncdtc_sin_size == %u\n", size);
+        write_split_table(output_file, "sin", values, size);
+}
+
+static void write_atan(FILE *output_file, unsigned int size,
+                       unsigned int sin_size)
+{
+        uint8_t bytes[256];
+
+        for (unsigned int i = 0; i <= size; i++)
+        {
+                bytes[i] = lround(atan((double)i / size) * sin_size /
+                                  (2.0 * M_PI));
+        }
+
+        fprintf(output_file, "\ncdtc_atan_size == %u\n", size);
+        write_bytes(output_file, "cdtc_atan_octant", bytes, size + 1);
+}
+
+static void write_recip(FILE *output_file, unsigned int size)
+{
+        int32_t values[256];
+
+        values[0] = 65535;
+        for (unsigned int i = 1; i < size; i++)
+        {
+                long v = lround(65536.0 / i);
+                values[i] = v > 65535 ? 65535 : v;
+        }
+
+        fprintf(output_file, "\ncdtc_recip_size == %u\n", size);
+        write_split_table(output_file, "recip", values, size);
+}
+
+static void write_sqrt(FILE *output_file, unsigned int size)
+{
+        int32_t values[256];
+
+        for (unsigned int i = 0; i < size; i++)
+        {
+                values[i] = lround(256.0 * sqrt(i));
+        }
+
+        fprintf(output_file, "\ncdtc_sqrt_size == %u\n", size);
+        write_split_table(output_file, "sqrt", values, size);
+}
+
+int main(int argc, const char **argv)
+{
+        struct arguments arguments;
+        memset(&arguments, 0, sizeof(arguments));
+        arguments.area_name = area_name_default;
+        arguments.sin_size = 256;
+        arguments.atan_size = 128;
+        arguments.recip_size = 256;
+        arguments.sqrt_size = 256;
+
+        /* Parse our arguments; every option seen by parse_opt will
+           be reflected in arguments. */
+        argp_parse(&argp, argc, (char **restrict)argv, 0, 0, &arguments);
+
+        FILE *output_file = fopen(arguments.output_file, "w");
+        if (output_file == NULL)
+        {
+                perror(arguments.output_file);
+                exit(1);
+        }
+
+        fprintf(output_file, ".module cdtc_tables\n\n");
+        fprintf(output_file,
+                "; Generated by cdtc_tablegen, see "
+                "cpclib/cdtc/include/cdtc/fixed_tables.h\n\n");
+        fprintf(output_file, ".area %s\n", arguments.area_name);
+
+        if (arguments.sin)
+        {
+                write_sin(output_file, arguments.sin_size);
+        }
+        if (arguments.atan)
+        {
+                write_atan(output_file, arguments.atan_size,
+                           arguments.sin_size);
+        }
+        if (arguments.recip)
+        {
+                write_recip(output_file, arguments.recip_size);
+        }
+        if (arguments.sqrt)
+        {
+                write_sqrt(output_file, arguments.sqrt_size);
+        }
+
+        fclose(output_file);
+
+        printf("Success. Exiting.\n");
+
+        exit(0);
+}
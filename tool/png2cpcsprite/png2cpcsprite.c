@@ -3,9 +3,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
 #include <zlib.h>
 
 #include <argp.h>
+#include <dirent.h>
 #include <stdbool.h>
 
 const char *argp_program_version = "png2cpcsprite 0.1";
@@ -47,7 +54,20 @@ static char doc[] =
         "runtime resources that you actually need.  Output format is an "
         "assembly source text file with data as bytes and metadata available "
         "as symbols: bytes, height, pixels_per_line, bytes_per_line, "
-        "palette_count and as many palette_ink_* as needed.\n"
+        "palette_count and as many palette_ink_* as needed, plus push_* "
+        "symbols with --layout=push and a charblocks table with "
+        "--charblock.  With --plus_sprites, data is CPC Plus hardware "
+        "sprites instead, with plus_sprite_* symbols and a plus_palette "
+        "table.\n"
+        "\n"
+        "With --atlas, several images are packed in one output file.  Each "
+        "sprite gets its usual symbols plus rows_per_page, bank, offset and "
+        "index.  A sprite of up to 256 bytes never crosses a page boundary; a "
+        "bigger one is split into chunks of rows_per_page lines, each chunk at "
+        "the start of the next page, so that a blitter can always use 8-bit "
+        "increments within a line.  Tables <atlas>_offset_low, "
+        "<atlas>_offset_high and <atlas>_bank, indexed by sprite index, each "
+        "start on a page boundary.\n"
         "\n"
         "A flexible prefix scheme for symbol names is used to prevent any "
         "symbol name conflict.  Similarly for module names, this allows you to "
@@ -55,8 +75,11 @@ static char doc[] =
         "run-time CPC memory without resorting to manually specifying too "
         "much.\n"
         "\n"
-        "Current output format is for sdasz80 (the one shipped with SDCC).  If "
-        "you need another assembler output format, please ask.\n"
+        "Default output format is for sdasz80 (the one shipped with SDCC).  "
+        "With --assembler=rasm, output is for rasm instead: metadata as EQU "
+        "and data as an INCBIN of a binary file written alongside, which "
+        "rasm assembles much faster than parsing bytes as text, and which it "
+        "can optionally crunch at assembly time (see --rasm_crunch).\n"
         "\n"
         "## Modes of operation\n\n"
         "There are two modes of operation: index-based and color-based.\n"
@@ -92,6 +115,59 @@ static struct argp_option options[] = {
          "Output format specification: 0 plain data. 1 interleaved (1 "
          "byte transparency mask, 1 byte masked data).",
          1},
+        {"report", 4, "<json>", 0,
+         "Optional.  "
+         "Also write a machine-readable report of the conversion: "
+         "dimensions, mode, byte count of each generated variant, that "
+         "count relative to the input PNG file size (not a compression "
+         "ratio, PNG being compressed itself), palette and time spent in "
+         "each processing stage.  With --rasm_crunch, the crunched size is "
+         "only known once rasm assembles the output, which the report "
+         "states.  Intended to be aggregated by a build step into a "
+         "per-project memory budget.  Only 'json' is supported.",
+         1},
+        {"report_file", 5, "<report_filename.json>", 0,
+         "Optional.  "
+         "Path where the report will be written.  "
+         "Default is the output file path with '.report.json' appended.",
+         1},
+        {"assembler", 6, "<sdasz80> or <rasm>", 0,
+         "Optional.  "
+         "Assembler syntax of the output file.  Default is 'sdasz80'.  "
+         "With 'rasm', sprite data is written as a binary file next to the "
+         "output file (output file path with '.bin' appended) and the output "
+         "file refers to it through INCBIN.",
+         1},
+        {"watch", 12, "<directory>", 0,
+         "Optional.  "
+         "Instead of converting one file, keep running and convert every "
+         "foo.png in <directory> to foo.generated.s (foo.generated.asm with "
+         "--assembler=rasm), like the cpc-dev-tool-chain Makefile rule "
+         "does, first for outputs that are missing or older than their "
+         "input, then each time a PNG file is written or moved in.  Input "
+         "files whose content did not change are skipped, outputs whose "
+         "content did not change are not rewritten, and colour matching "
+         "results are kept from one conversion to the next.  Other options "
+         "apply to every conversion, except input, output, name_stem and "
+         "report_file.",
+         1},
+        {"atlas", 10, 0, 0,
+         "Optional.  "
+         "Pack several images into one output file: input files are the "
+         "'input' option, if any, followed by non-option arguments.  Sprites "
+         "are packed in 16 KB banks so that no sprite line crosses a 256-byte "
+         "page boundary, and page-aligned tables of bank-relative offsets "
+         "are generated.  The data must be linked at a page-aligned address.  "
+         "Symbols of each sprite are named after its file, the atlas itself "
+         "after --name_stem or else the output file.",
+         1},
+        {"rasm_crunch", 7, "<lz4|lz48|lz49|lzx7|lzexo>", 0,
+         "Optional, requires --assembler=rasm.  "
+         "Wrap the INCBIN in a rasm crunched section of the given kind, so "
+         "that rasm compresses the data at assembly time.  Labels then mark "
+         "crunched data, and a matching decruncher must be used at run "
+         "time.",
+         1},
         {0, 0, 0, 0, "Processing", 2},
         {"palette", 'p', "colorcode[,colorcode]*", 0,
          "Optional.  "
@@ -122,6 +198,43 @@ static struct argp_option options[] = {
          "processing bottom to top.  Correct value depend on your context, "
          "especially sprite write routine.",
          2},
+        {"layout", 8, "<plain> or <push>", 0,
+         "Optional.  "
+         "Default 'plain' writes each line left to right.  'push' writes "
+         "each line as 16-bit words from the right end of the line to the "
+         "left, so that a copy loop can 'pop' them from sprite data and "
+         "'push' them to screen memory with SP set to the end of the "
+         "destination line.  Lines must then have an even number of bytes, "
+         "see --pad_odd_width.",
+         2},
+        {"plus_sprites", 13, 0, 0,
+         "Optional.  "
+         "Instead of CPC screen bytes, generate CPC Plus hardware sprites: "
+         "the image is cut into 16x16 sprites in reading order, extended "
+         "with pen 0 (transparent) to a multiple of 16 pixels, with one "
+         "byte per pixel holding the pen in its low nibble, ready to be "
+         "copied to ASIC RAM at &4000.  The mode option is ignored.  A "
+         "_plus_palette table holds pens 1 to 15 in Plus format, two "
+         "bytes each (red << 4 | blue, then green), from the PNG colormap "
+         "rounded to 4 bits per component, or with -p from the CPC inks "
+         "as levels 0, 6 and F.",
+         2},
+        {"charblock", 11, "<phase>", 0,
+         "Optional.  "
+         "Also generate a table of 8-line character blocks, for a blitter "
+         "that steps +&800 between lines of a block without testing for the "
+         "wrap, and handles it once per block.  <phase> (0 to 7) is the "
+         "pixel line within a character row where the top sprite line will "
+         "be drawn, which sets where blocks start.  Each table entry is a "
+         "byte of line count followed by a word of offset from the data "
+         "label, in output order.",
+         2},
+        {"pad_odd_width", 9, "<left> or <right>", 0,
+         "Optional, only meaningful with --layout=push.  "
+         "Lines with an odd number of bytes get an extra byte of value 0 on "
+         "this side, which the copy loop will also write to screen.  "
+         "Without this option an odd width is an error.",
+         2},
         {0, 0, 0, 0, "Assembly-level naming", 3},
         {"name_stem", 'n', "somename", 0,
          "Optional.  "
@@ -167,6 +280,33 @@ static struct argp_option options[] = {
 
 #define MAX_EXPLICIT_PALETTE_COUNT 27
 
+typedef enum assembler_flavor
+{
+        ASSEMBLER_SDASZ80,
+        ASSEMBLER_RASM
+} assembler_flavor;
+
+#define MAX_ATLAS_SPRITES 256
+
+typedef enum sprite_layout
+{
+        LAYOUT_PLAIN,
+        LAYOUT_PUSH
+} sprite_layout;
+
+typedef enum pad_side
+{
+        PAD_NONE,
+        PAD_LEFT,
+        PAD_RIGHT
+} pad_side;
+
+/* Values accepted by --rasm_crunch, and the rasm directive that opens
+ * the corresponding crunched section. */
+static const char *rasm_crunch_kinds[][2] = {
+        {"lz4", "LZ4"},   {"lz48", "LZ48"},   {"lz49", "LZ49"},
+        {"lzx7", "LZX7"}, {"lzexo", "LZEXO"}, {NULL, NULL}};
+
 struct arguments
 {
         char *input_file;
@@ -179,6 +319,22 @@ struct arguments
         char *symbol_format_string;
         char *module_format_string;
         char *area_format_string;
+        char *report_format;
+        char *report_file;
+        assembler_flavor assembler;
+        const char *rasm_crunch_directive;
+        sprite_layout layout;
+        pad_side pad_odd_width;
+        bool plus_sprites;
+        bool charblock;
+        u_int8_t charblock_phase;
+        bool atlas;
+        char *atlas_input_files[MAX_ATLAS_SPRITES];
+        int atlas_input_file_count;
+        /* More than one -i, where only the last one is used. */
+        bool input_file_repeated;
+        char *watch_directory;
+        bool write_only_if_changed;
         unsigned int explicit_palette[MAX_EXPLICIT_PALETTE_COUNT];
         int explicit_palette_count;
         int verbose;
@@ -260,16 +416,85 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
         case ARGP_KEY_NO_ARGS:
                 return 0;
         case ARGP_KEY_END:
-                if (arguments->input_file == NULL)
+                if (arguments->atlas_input_file_count > 0 && !arguments->atlas)
+                {
+                        reason = "stray argument";
+                        arg = arguments->atlas_input_files[0];
+                        goto invalid;
+                }
+                if (arguments->atlas && arguments->input_file_repeated)
+                {
+                        reason = "with --atlas, give further input files "
+                                 "as arguments, not with another -i";
+                        arg = arguments->input_file;
+                        goto invalid;
+                }
+                if (arguments->atlas && arguments->input_file != NULL)
+                {
+                        if (arguments->atlas_input_file_count ==
+                            MAX_ATLAS_SPRITES)
+                        {
+                                reason = "too many input files for atlas";
+                                goto invalid;
+                        }
+                        memmove(arguments->atlas_input_files + 1,
+                                arguments->atlas_input_files,
+                                arguments->atlas_input_file_count *
+                                        sizeof(char *));
+                        arguments->atlas_input_files[0] =
+                                arguments->input_file;
+                        arguments->atlas_input_file_count++;
+                }
+                if (arguments->watch_directory != NULL && arguments->atlas)
+                {
+                        reason = "--watch is not supported with --atlas";
+                        goto invalid;
+                }
+                if (arguments->atlas &&
+                    arguments->atlas_input_file_count == 0)
                 {
                         reason = "missing input file";
                         goto invalid;
                 }
-                if (arguments->output_file == NULL)
+                if (!arguments->atlas && arguments->input_file == NULL &&
+                    arguments->watch_directory == NULL)
+                {
+                        reason = "missing input file";
+                        goto invalid;
+                }
+                if (arguments->output_file == NULL &&
+                    arguments->watch_directory == NULL)
                 {
                         reason = "missing output file";
                         goto invalid;
                 }
+                if (arguments->rasm_crunch_directive != NULL &&
+                    arguments->assembler != ASSEMBLER_RASM)
+                {
+                        reason = "--rasm_crunch requires --assembler=rasm";
+                        goto invalid;
+                }
+                if (arguments->plus_sprites &&
+                    (arguments->atlas || arguments->charblock ||
+                     arguments->layout != LAYOUT_PLAIN ||
+                     arguments->bottom_to_top))
+                {
+                        reason = "--plus_sprites does not combine with "
+                                 "--atlas, --charblock, --layout or -d b";
+                        goto invalid;
+                }
+                if (arguments->charblock && arguments->atlas)
+                {
+                        reason = "--charblock is not supported with --atlas";
+                        goto invalid;
+                }
+                if (arguments->rasm_crunch_directive != NULL &&
+                    arguments->atlas)
+                {
+                        reason = "--rasm_crunch would make atlas offsets "
+                                 "meaningless";
+                        goto invalid;
+                }
 
                 return 0;
         case ARGP_KEY_SUCCESS:
@@ -277,9 +502,22 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
         case ARGP_KEY_FINI:
                 return 0;
         case ARGP_KEY_ARG:
-                reason = "stray argument";
-                goto invalid;
-                break;
+                /* Only valid with --atlas, which may come later on the
+                 * command line, so this is checked at ARGP_KEY_END. */
+                if (arguments->atlas_input_file_count == MAX_ATLAS_SPRITES)
+                {
+                        reason = "too many input files for atlas";
+                        goto invalid;
+                }
+                arguments->atlas_input_files
+                        [arguments->atlas_input_file_count++] = arg;
+                return 0;
+        case 10: /* atlas, takes no parameter */
+                arguments->atlas = true;
+                return 0;
+        case 13: /* plus_sprites, takes no parameter */
+                arguments->plus_sprites = true;
+                return 0;
 
         default:
                 break;
@@ -461,8 +699,51 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
         switch (key)
         {
         case 'i':
+                arguments->input_file_repeated = arguments->input_file != NULL;
                 arguments->input_file = arg;
                 break;
+        case 4: /* report */
+                if (strcmp(arg, "json") != 0)
+                {
+                        reason = "only 'json' is supported";
+                        goto invalid;
+                }
+                arguments->report_format = arg;
+                break;
+        case 5: /* report_file */
+                arguments->report_file = arg;
+                break;
+        case 6: /* assembler */
+                if (strcmp(arg, "sdasz80") == 0)
+                {
+                        arguments->assembler = ASSEMBLER_SDASZ80;
+                        break;
+                }
+                if (strcmp(arg, "rasm") == 0)
+                {
+                        arguments->assembler = ASSEMBLER_RASM;
+                        break;
+                }
+                reason = "neither sdasz80 nor rasm";
+                goto invalid;
+                break;
+        case 7: /* rasm_crunch */
+                arguments->rasm_crunch_directive = NULL;
+                for (int i = 0; rasm_crunch_kinds[i][0] != NULL; i++)
+                {
+                        if (strcmp(arg, rasm_crunch_kinds[i][0]) == 0)
+                        {
+                                arguments->rasm_crunch_directive =
+                                        rasm_crunch_kinds[i][1];
+                                break;
+                        }
+                }
+                if (arguments->rasm_crunch_directive == NULL)
+                {
+                        reason = "unknown crunch kind";
+                        goto invalid;
+                }
+                break;
         case 'f':
         {
                 char *end;
@@ -498,6 +779,46 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
         case 'o':
                 arguments->output_file = arg;
                 break;
+        case 8: /* layout */
+                if (strcmp(arg, "plain") == 0)
+                {
+                        arguments->layout = LAYOUT_PLAIN;
+                        break;
+                }
+                if (strcmp(arg, "push") == 0)
+                {
+                        arguments->layout = LAYOUT_PUSH;
+                        break;
+                }
+                reason = "neither plain nor push";
+                goto invalid;
+                break;
+        case 12: /* watch */
+                arguments->watch_directory = arg;
+                break;
+        case 11: /* charblock */
+                if (arg[0] < '0' || arg[0] > '7' || arg[1] != 0)
+                {
+                        reason = "not a digit from 0 to 7";
+                        goto invalid;
+                }
+                arguments->charblock = true;
+                arguments->charblock_phase = arg[0] - '0';
+                break;
+        case 9: /* pad_odd_width */
+                if (strcmp(arg, "left") == 0)
+                {
+                        arguments->pad_odd_width = PAD_LEFT;
+                        break;
+                }
+                if (strcmp(arg, "right") == 0)
+                {
+                        arguments->pad_odd_width = PAD_RIGHT;
+                        break;
+                }
+                reason = "neither left nor right";
+                goto invalid;
+                break;
         case 'd':
                 // Assert only one character.
                 if (arg[1] != 0)
@@ -626,6 +947,50 @@ find_palette_index_closest_to_this_rgb_triplet(struct arguments *arguments,
         return squared_distance_min_index;
 }
 
+/* Memo of find_palette_index_closest_to_this_rgb_triplet() for
+ * truecolor input, direct-mapped on the RGB value.  In --watch mode it
+ * lives in shared memory, so that conversions run in child processes
+ * keep it warm for the next ones.  The palette does not change during
+ * a run, so entries never go stale. */
+
+#define RGB_TO_INK_CACHE_SIZE 4096
+
+typedef struct rgb_to_ink_cache_entry
+{
+        u_int32_t rgb_plus_one;
+        u_int8_t ink;
+} rgb_to_ink_cache_entry;
+
+rgb_to_ink_cache_entry *rgb_to_ink_cache = NULL;
+
+u_int8_t closest_palette_index_cached(struct arguments *arguments,
+                                      u_int8_t *pixeldata)
+{
+        if (rgb_to_ink_cache == NULL)
+        {
+                rgb_to_ink_cache = calloc(RGB_TO_INK_CACHE_SIZE,
+                                          sizeof(rgb_to_ink_cache_entry));
+                if (rgb_to_ink_cache == NULL)
+                {
+                        return find_palette_index_closest_to_this_rgb_triplet(
+                                arguments, pixeldata);
+                }
+        }
+
+        u_int32_t rgb = pixeldata[0] << 16 | pixeldata[1] << 8 | pixeldata[2];
+        rgb_to_ink_cache_entry *entry =
+                &rgb_to_ink_cache[(rgb ^ rgb >> 12) % RGB_TO_INK_CACHE_SIZE];
+
+        if (entry->rgb_plus_one != rgb + 1)
+        {
+                entry->ink = find_palette_index_closest_to_this_rgb_triplet(
+                        arguments, pixeldata);
+                entry->rgb_plus_one = rgb + 1;
+        }
+
+        return entry->ink;
+}
+
 #define maxargs 5
 #define STR_HELPER(x) #x
 #define STR(x) STR_HELPER(x)
@@ -635,207 +1000,1209 @@ u_int8_t max_color_count_for_mode(u_int8_t m)
         return (1 << (1 << (2 - (m))));
 }
 
-int main(int argc, const char **argv)
+/* Decoded image: one index per pixel, packed as in PNG rows (1, 2, 4
+ * or 8 bits per pixel, leftmost pixel in most significant bits), plus
+ * the RGB value of each index. */
+typedef struct indexed_image
 {
-        struct arguments arguments;
-        memset(&arguments, 0, sizeof(arguments));
-        arguments.symbol_format_string = symbol_format_string_default;
-        arguments.module_format_string = module_format_string_default;
-        arguments.area_format_string = area_format_string_default;
+        png_uint_32 width;
+        png_uint_32 height;
+        int bit_depth;
+        size_t row_bytes;
+        u_int8_t *pixels;
+        unsigned int colormap_entries;
+        u_int8_t colormap[256 * 3];
+        // When true, pixels are already indices in the explicit palette
+        // and colormap is meaningless.
+        bool pixels_are_explicit_palette_indices;
+} indexed_image;
+
+static inline u_int8_t indexed_image_get(const indexed_image *image,
+                                         png_uint_32 x, png_uint_32 y)
+{
+        const u_int8_t *row = image->pixels + image->row_bytes * y;
+        int depth = image->bit_depth;
 
-        /* Parse our arguments; every option seen by parse_opt will
-           be reflected in arguments. */
-        argp_parse(&argp, argc, (char **restrict)argv, 0, 0, &arguments);
+        if (depth == 8)
+        {
+                return row[x];
+        }
 
-        if (arguments.explicit_palette_count > 0)
+        int pixels_per_byte = 8 / depth;
+        int shift = 8 - depth * (1 + x % pixels_per_byte);
+
+        return (row[x / pixels_per_byte] >> shift) & ((1 << depth) - 1);
+}
+
+/* Palette and grey images up to 8 bits are read with the low-level
+ * libpng API, keeping pixels as packed indices: no RGB expansion.
+ * Returns false, without side effect, for any other kind of image. */
+bool decode_png_indexed(const char *file_name, indexed_image *image)
+{
+        FILE *f = fopen(file_name, "rb");
+
+        if (f == NULL)
         {
-                printf("Explicit palette provided with %d entries:",
-                       arguments.explicit_palette_count);
+                fprintf(stderr, "png2cpcsprite: error: cannot open '%s'.\n",
+                        file_name);
+                exit(1);
+        }
 
-                for (int i = 0; i < arguments.explicit_palette_count; i++)
-                {
-                        printf(" %d", arguments.explicit_palette[i]);
-                }
-                printf("\n");
+        png_structp png_ptr =
+                png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info_ptr = png_create_info_struct(png_ptr);
+
+        if (png_ptr == NULL || info_ptr == NULL)
+        {
+                fprintf(stderr, "png2cpcsprite: error: cannot initialize "
+                                "libpng.\n");
+                exit(1);
         }
-        else
+
+        if (setjmp(png_jmpbuf(png_ptr)))
         {
-                printf("Explicit palette not provided.\n");
+                // libpng already printed a message.
+                fprintf(stderr, "png2cpcsprite: error: could not decode "
+                                "'%s'.\n",
+                        file_name);
+                exit(1);
         }
 
-        png_image image;
-        size_t buffer_size;
+        png_init_io(png_ptr, f);
+        png_read_info(png_ptr, info_ptr);
 
-        png_bytep buffer_for_colormap;
-        png_bytep buffer;
+        int color_type = png_get_color_type(png_ptr, info_ptr);
+        int bit_depth = png_get_bit_depth(png_ptr, info_ptr);
 
+        if (!(color_type == PNG_COLOR_TYPE_PALETTE ||
+              (color_type == PNG_COLOR_TYPE_GRAY && bit_depth <= 8)))
         {
-                memset(&image, 0, (sizeof image));
-                image.version = PNG_IMAGE_VERSION;
-                image.opaque = NULL;
+                png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+                fclose(f);
+                return false;
+        }
 
-                {
-                        printf("Will read from %s\n", arguments.input_file);
+        memset(image, 0, sizeof(*image));
+        image->width = png_get_image_width(png_ptr, info_ptr);
+        image->height = png_get_image_height(png_ptr, info_ptr);
+        image->bit_depth = bit_depth;
 
-                        /* The first argument is the file to read: */
-                        if (png_image_begin_read_from_file(
-                                    &image, arguments.input_file) == 0)
-                        {
-                                fprintf(stderr, "png2cpcsprite: error: %s\n",
-                                        image.message);
-                                exit(1);
-                        }
-                }
+        if (color_type == PNG_COLOR_TYPE_PALETTE)
+        {
+                png_colorp palette;
+                int num_palette;
 
-                printf("Started decoding, found dimensions %u x %u, %u "
-                       "colors, input libpng format code 0x%x.\n",
-                       image.width, image.height, image.colormap_entries,
-                       image.format);
+                png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
 
-                if (PNG_FORMAT_FLAG_ALPHA & image.format)
+                image->colormap_entries = num_palette;
+                for (int i = 0; i < num_palette; i++)
                 {
-                        fprintf(stderr,
-                                "Warning: image format says it has "
-                                "transparency.  "
-                                "This programm cannot currently generate "
-                                "sprites with transparent areas.  "
-                                "For the sake of accepting this input I will "
-                                "just assume that maybe you don't actually use "
-                                "transparent or semi-transparent colors, and "
-                                "ask the PNG decoder to just flatten partially "
-                                "transparent areas assuming a black "
-                                "background.  This may not be what you "
-                                "want.\n");
+                        image->colormap[i * 3] = palette[i].red;
+                        image->colormap[i * 3 + 1] = palette[i].green;
+                        image->colormap[i * 3 + 2] = palette[i].blue;
                 }
+        }
+        else
+        {
+                unsigned int max_value = (1 << bit_depth) - 1;
 
-                image.format = PNG_FORMAT_RGB;
-
-                // If no colormap is provided, will just pass the values
-                // through.
-                if (arguments.explicit_palette_count == 0)
+                image->colormap_entries = max_value + 1;
+                for (unsigned int i = 0; i <= max_value; i++)
                 {
-                        image.format |= PNG_FORMAT_FLAG_COLORMAP;
+                        u_int8_t grey = i * 255 / max_value;
+                        image->colormap[i * 3] = grey;
+                        image->colormap[i * 3 + 1] = grey;
+                        image->colormap[i * 3 + 2] = grey;
                 }
+        }
 
-                printf("Will decode with libpng format code 0x%x.\n",
-                       image.format);
+        if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+        {
+                fprintf(stderr,
+                        "Warning: image has transparency information.  "
+                        "This programm cannot currently generate sprites "
+                        "with transparent areas.  Transparency is ignored, "
+                        "pixel indices are used as they are.  This may not "
+                        "be what you want.\n");
+        }
 
-                buffer_size = PNG_IMAGE_SIZE(image);
-                buffer = malloc(buffer_size);
+        printf("Started decoding, found dimensions %u x %u, %u colors, "
+               "%d bits per pixel, decoding indices directly.\n",
+               image->width, image->height, image->colormap_entries,
+               bit_depth);
 
-                if (buffer == NULL)
-                {
-                        fprintf(stderr,
-                                "png2cpcsprite: could not allocate %lu bytes "
-                                "for image",
-                                buffer_size);
-                        // Yes, we don't cleanup.  Quick and dirty!
-                        exit(1);
-                }
+        png_set_interlace_handling(png_ptr);
+        png_read_update_info(png_ptr, info_ptr);
 
-                {
-                        size_t colormap__size = PNG_IMAGE_COLORMAP_SIZE(image);
-                        buffer_for_colormap = malloc(colormap__size);
+        image->row_bytes = png_get_rowbytes(png_ptr, info_ptr);
+        image->pixels = malloc(image->row_bytes * image->height);
 
-                        if (buffer == NULL)
-                        {
-                                fprintf(stderr,
-                                        "png2cpcsprite: could not allocate %lu "
-                                        "bytes "
-                                        "for colormap",
-                                        colormap__size);
-                                // Yes, we don't cleanup.  Quick and dirty!
-                                exit(1);
-                        }
-                }
+        png_bytep *row_pointers = malloc(sizeof(png_bytep) * image->height);
 
-                png_color black = {0, 0, 0};
+        if (image->pixels == NULL || row_pointers == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: could not allocate %lu bytes for "
+                        "image",
+                        image->row_bytes * image->height);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
 
-                if (png_image_finish_read(&image, &black, buffer,
-                                          0 /*row_stride*/,
-                                          buffer_for_colormap) == 0)
-                {
-                        fprintf(stderr, "png2cpcsprite: error: %s\n",
-                                image.message);
-                        // Yes, we don't cleanup.  Quick and dirty!
-                        exit(1);
-                }
+        for (png_uint_32 y = 0; y < image->height; y++)
+        {
+                row_pointers[y] = image->pixels + image->row_bytes * y;
         }
 
-        printf("Finished decoding PNG. Processing.\n");
+        png_read_image(png_ptr, row_pointers);
+        png_read_end(png_ptr, NULL);
 
-        if (!arguments.crtc_mode_explicitly_set)
-        {
-                printf("CRTC mode not determined by command line.\n");
-                if (arguments.explicit_palette_count > 0)
-                {
-                        printf("Guessing from command-line colormap count (%u "
-                               "entries).\n",
-                               arguments.explicit_palette_count);
-                        arguments.crtc_mode =
-                                guess_crtc_mode_based_on_colormap_entry_count(
-                                        arguments.explicit_palette_count);
+        free(row_pointers);
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+        fclose(f);
 
-                        if (arguments.crtc_mode == 4)
-                        {
-                                fprintf(stderr,
-                                        "Internal error: "
-                                        "guess_crtc_mode_based_on_colormap_"
-                                        "entry_count returned an unexpected "
-                                        "value.  Too many explicit palette "
-                                        "entries (%u)?\n",
-                                        arguments.explicit_palette_count);
-                                exit(1);
-                        }
-                }
-                else
-                {
-                        printf("Guessing from image colormap count (%u "
-                               "entries).\n",
-                               image.colormap_entries);
-                        arguments.crtc_mode =
-                                guess_crtc_mode_based_on_colormap_entry_count(
-                                        image.colormap_entries);
-                        if (arguments.crtc_mode == 4)
-                        {
-                                fprintf(stderr,
-                                        "Error: the PNG palette has too many "
-                                        "colors (%u) for the CPC, "
-                                        "not trying to guess "
-                                        "mode.  Please prepare the picture for "
-                                        "the CPC.  In the "
-                                        "special case where your picture is "
-                                        "indeed prepared, actually "
-                                        "uses the first indices of the palette "
-                                        "only and only happens "
-                                        "to have extraneous colormap entries "
-                                        "at PNG level, set mode "
-                                        "explicitly, for example: -mode 1 .\n",
-                                        image.colormap_entries);
-                                exit(1);
-                        }
-                }
+        return true;
+}
+
+/* Any other image goes through libpng simplified API.  Without explicit
+ * palette, libpng builds a colormap.  With explicit palette, each RGB
+ * pixel is matched to the closest palette entry while reading. */
+void decode_png_simplified(struct arguments *arguments, indexed_image *image)
+{
+        png_image simplified;
+
+        memset(&simplified, 0, (sizeof simplified));
+        simplified.version = PNG_IMAGE_VERSION;
+        simplified.opaque = NULL;
+
+        if (png_image_begin_read_from_file(&simplified,
+                                           arguments->input_file) == 0)
+        {
+                fprintf(stderr, "png2cpcsprite: error: %s\n",
+                        simplified.message);
+                exit(1);
         }
 
-        unsigned int max_color_count_for_selected_mode =
-                max_color_count_for_mode(arguments.crtc_mode);
+        printf("Started decoding, found dimensions %u x %u, %u "
+               "colors, input libpng format code 0x%x.\n",
+               simplified.width, simplified.height,
+               simplified.colormap_entries, simplified.format);
 
-        printf("CRTC mode selected: %u, which means a palette of %u colors.\n",
-               arguments.crtc_mode, max_color_count_for_selected_mode);
+        if (PNG_FORMAT_FLAG_ALPHA & simplified.format)
+        {
+                fprintf(stderr,
+                        "Warning: image format says it has "
+                        "transparency.  "
+                        "This programm cannot currently generate "
+                        "sprites with transparent areas.  "
+                        "For the sake of accepting this input I will "
+                        "just assume that maybe you don't actually use "
+                        "transparent or semi-transparent colors, and "
+                        "ask the PNG decoder to just flatten partially "
+                        "transparent areas assuming a black "
+                        "background.  This may not be what you "
+                        "want.\n");
+        }
+
+        simplified.format = PNG_FORMAT_RGB;
 
-        if (arguments.explicit_palette_count == 0)
+        // If no colormap is provided, will just pass the values
+        // through.
+        if (arguments->explicit_palette_count == 0)
         {
-                printf("No palette provided on command line.  Assuming that "
-                       "your nicely prepared your PNG with a "
-                       "nice palette specially for the CPC.   Will map RGB "
-                       "information from PNG image to CPC colors.\n");
+                simplified.format |= PNG_FORMAT_FLAG_COLORMAP;
+        }
 
-                u_int8_t entries_in_generated_cpc_palette =
-                        image.colormap_entries;
+        printf("Will decode with libpng format code 0x%x.\n",
+               simplified.format);
 
-                if (image.colormap_entries > max_color_count_for_selected_mode)
-                {
-                        fprintf(stderr,
+        size_t buffer_size = PNG_IMAGE_SIZE(simplified);
+        png_bytep buffer = malloc(buffer_size);
+
+        if (buffer == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: could not allocate %lu bytes "
+                        "for image",
+                        buffer_size);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        memset(image, 0, sizeof(*image));
+
+        png_color black = {0, 0, 0};
+
+        if (png_image_finish_read(&simplified, &black, buffer,
+                                  0 /*row_stride*/, image->colormap) == 0)
+        {
+                fprintf(stderr, "png2cpcsprite: error: %s\n",
+                        simplified.message);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        image->width = simplified.width;
+        image->height = simplified.height;
+        image->bit_depth = 8;
+        image->row_bytes = simplified.width;
+        image->colormap_entries = simplified.colormap_entries;
+
+        if (PNG_FORMAT_FLAG_COLORMAP & simplified.format)
+        {
+                image->pixels = buffer;
+                return;
+        }
+
+        size_t pixel_count = (size_t)simplified.width * simplified.height;
+
+        image->pixels = malloc(pixel_count);
+
+        if (image->pixels == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: could not allocate %lu bytes "
+                        "for image",
+                        pixel_count);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        for (size_t i = 0; i < pixel_count; i++)
+        {
+                image->pixels[i] =
+                        closest_palette_index_cached(arguments, buffer + i * 3);
+        }
+
+        image->pixels_are_explicit_palette_indices = true;
+        free(buffer);
+}
+
+/* Everything the machine-readable report needs, gathered along the
+ * conversion.  Stages and variants are appended in the order they
+ * happen. */
+
+#define MAX_REPORT_STAGES 8
+#define MAX_REPORT_VARIANTS 8
+
+typedef struct report_stage
+{
+        const char *name;
+        double milliseconds;
+} report_stage;
+
+typedef struct report_variant
+{
+        const char *name;
+        unsigned int bytes;
+} report_variant;
+
+typedef struct conversion_report
+{
+        struct timespec stage_start;
+        report_stage stages[MAX_REPORT_STAGES];
+        int stage_count;
+        report_variant variants[MAX_REPORT_VARIANTS];
+        int variant_count;
+        long input_file_bytes;
+        unsigned int width_pixels;
+        unsigned int width_bytes;
+        unsigned int height;
+} conversion_report;
+
+void report_start_stage(conversion_report *report)
+{
+        clock_gettime(CLOCK_MONOTONIC, &report->stage_start);
+}
+
+void report_end_stage(conversion_report *report, const char *name)
+{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (report->stage_count == MAX_REPORT_STAGES)
+        {
+                return;
+        }
+
+        report_stage *stage = &report->stages[report->stage_count++];
+        stage->name = name;
+        stage->milliseconds =
+                (now.tv_sec - report->stage_start.tv_sec) * 1e3 +
+                (now.tv_nsec - report->stage_start.tv_nsec) / 1e6;
+
+        report->stage_start = now;
+}
+
+void report_add_variant(conversion_report *report, const char *name,
+                        unsigned int bytes)
+{
+        if (report->variant_count == MAX_REPORT_VARIANTS)
+        {
+                return;
+        }
+
+        report->variants[report->variant_count].name = name;
+        report->variants[report->variant_count].bytes = bytes;
+        report->variant_count++;
+}
+
+void json_write_string(FILE *f, const char *s)
+{
+        fputc('"', f);
+        for (; *s; s++)
+        {
+                unsigned char c = *s;
+                if (c == '"' || c == '\\')
+                {
+                        fprintf(f, "\\%c", c);
+                }
+                else if (c < 0x20)
+                {
+                        fprintf(f, "\\u%04x", c);
+                }
+                else
+                {
+                        fputc(c, f);
+                }
+        }
+        fputc('"', f);
+}
+
+void write_json_report(const struct arguments *arguments,
+                       const conversion_report *report,
+                       const char *symbol_name, const char *report_file_name)
+{
+        FILE *f = fopen(report_file_name, "w");
+
+        if (f == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: error: could not open report file "
+                        "'%s'.\n",
+                        report_file_name);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        fprintf(f, "{\n  \"tool\": ");
+        json_write_string(f, argp_program_version);
+        if (arguments->atlas)
+        {
+                fprintf(f, ",\n  \"input_files\": [");
+                for (int i = 0; i < arguments->atlas_input_file_count; i++)
+                {
+                        fprintf(f, "%s\n    ", i ? "," : "");
+                        json_write_string(f, arguments->atlas_input_files[i]);
+                }
+                fprintf(f, "\n  ]");
+        }
+        else
+        {
+                fprintf(f, ",\n  \"input_file\": ");
+                json_write_string(f, arguments->input_file);
+        }
+        fprintf(f, ",\n  \"output_file\": ");
+        json_write_string(f, arguments->output_file);
+        fprintf(f, ",\n  \"symbol\": ");
+        json_write_string(f, symbol_name);
+        fprintf(f, ",\n  \"input_file_bytes\": %ld", report->input_file_bytes);
+        fprintf(f, ",\n  \"crtc_mode\": %u", arguments->crtc_mode);
+        fprintf(f, ",\n  \"width_pixels\": %u", report->width_pixels);
+        fprintf(f, ",\n  \"width_bytes\": %u", report->width_bytes);
+        fprintf(f, ",\n  \"height\": %u", report->height);
+
+        fprintf(f, ",\n  \"palette\": [");
+        for (int i = 0; i < arguments->explicit_palette_count; i++)
+        {
+                unsigned int ink = arguments->explicit_palette[i];
+                fprintf(f,
+                        "%s\n    { \"pen\": %d, \"firmware_ink\": %u, "
+                        "\"hardware_ink\": %u }",
+                        i ? "," : "", i, ink, firmware_colors[ink]);
+        }
+        fprintf(f, "\n  ]");
+
+        fprintf(f, ",\n  \"variants\": [");
+        for (int i = 0; i < report->variant_count; i++)
+        {
+                const report_variant *v = &report->variants[i];
+                fprintf(f, "%s\n    { \"name\": ", i ? "," : "");
+                json_write_string(f, v->name);
+                fprintf(f, ", \"bytes\": %u", v->bytes);
+                if (report->input_file_bytes > 0)
+                {
+                        fprintf(f, ", \"size_relative_to_png_file\": %.3f",
+                                (double)v->bytes / report->input_file_bytes);
+                }
+                fprintf(f, " }");
+        }
+        fprintf(f, "\n  ]");
+
+        if (arguments->rasm_crunch_directive != NULL)
+        {
+                /* Variants count bytes before crunching. */
+                fprintf(f, ",\n  \"rasm_crunch\": { \"directive\": ");
+                json_write_string(f, arguments->rasm_crunch_directive);
+                fprintf(f, ", \"crunched_bytes\": null, \"note\": ");
+                json_write_string(f, "crunched size is only known once rasm "
+                                     "assembles the output");
+                fprintf(f, " }");
+        }
+
+        fprintf(f, ",\n  \"stages\": [");
+        for (int i = 0; i < report->stage_count; i++)
+        {
+                fprintf(f, "%s\n    { \"name\": ", i ? "," : "");
+                json_write_string(f, report->stages[i].name);
+                fprintf(f, ", \"milliseconds\": %.3f }",
+                        report->stages[i].milliseconds);
+        }
+        fprintf(f, "\n  ]\n}\n");
+
+        fclose(f);
+
+        printf("Wrote report file '%s'.\n", report_file_name);
+}
+
+/* Sprite data as it will be written: data_bytes_per_line may exceed
+ * width_bytes when the layout pads lines. */
+typedef struct converted_sprite
+{
+        u_int8_t *data;
+        unsigned int data_bytes;
+        unsigned int data_bytes_per_line;
+        unsigned int width_pixels;
+        unsigned int width_bytes;
+        unsigned int height;
+        bool padded_left;
+        unsigned int tiles_per_line;
+        unsigned int tile_lines;
+        u_int8_t plus_palette[15][2];
+} converted_sprite;
+
+/* Rearrange plain rows for a pop/push copy loop: each line becomes
+ * 16-bit words taken from the right end of the line, low byte first,
+ * so that "pop de ; push de" with SP at the end of the destination
+ * line lays bytes back in screen order. */
+converted_sprite arrange_for_push(const struct arguments *arguments,
+                                  const converted_sprite *plain)
+{
+        converted_sprite push = *plain;
+        bool odd = plain->width_bytes & 1;
+        unsigned int pad_before = odd && arguments->pad_odd_width == PAD_LEFT;
+
+        push.data_bytes_per_line = plain->width_bytes + odd;
+        push.data_bytes = push.data_bytes_per_line * plain->height;
+        push.padded_left = pad_before;
+        push.data = calloc(push.data_bytes, 1);
+
+        if (push.data == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: could not allocate %u bytes "
+                        "for push layout",
+                        push.data_bytes);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        u_int8_t line[push.data_bytes_per_line];
+
+        for (unsigned int y = 0; y < plain->height; y++)
+        {
+                memset(line, 0, sizeof(line));
+                memcpy(line + pad_before,
+                       plain->data + y * plain->data_bytes_per_line,
+                       plain->width_bytes);
+
+                u_int8_t *w = push.data + y * push.data_bytes_per_line;
+
+                for (int x = push.data_bytes_per_line - 2; x >= 0; x -= 2)
+                {
+                        *w++ = line[x];
+                        *w++ = line[x + 1];
+                }
+        }
+
+        return push;
+}
+
+/* Sprite rows are kept top to bottom in memory; this returns the
+ * row to emit at position yplain, honoring --direction. */
+const u_int8_t *sprite_row_in_output_order(const struct arguments *arguments,
+                                           const converted_sprite *sprite,
+                                           size_t yplain)
+{
+        size_t y = arguments->bottom_to_top ? sprite->height - 1 - yplain
+                                            : yplain;
+
+        return sprite->data + sprite->data_bytes_per_line * y;
+}
+
+void write_symbol_definition(const struct arguments *arguments,
+                             FILE *output_file, const char *symbol_name,
+                             const char *suffix, unsigned int value)
+{
+        if (arguments->assembler == ASSEMBLER_RASM)
+        {
+                fprintf(output_file, "%s_%s EQU %u\n", symbol_name, suffix,
+                        value);
+        }
+        else
+        {
+                fprintf(output_file, "%s_%s == %u\n", symbol_name, suffix,
+                        value);
+        }
+}
+
+/* Metadata symbols, common to all assembler flavors. */
+void write_metadata_symbols(const struct arguments *arguments,
+                            FILE *output_file, const char *symbol_name,
+                            const converted_sprite *sprite)
+{
+        if (arguments->assembler == ASSEMBLER_RASM)
+        {
+                fprintf(output_file, "%s_bytes EQU #%04X\n", symbol_name,
+                        sprite->data_bytes);
+        }
+        else
+        {
+                fprintf(output_file, "%s_bytes == 0x%04x\n", symbol_name,
+                        sprite->data_bytes);
+        }
+        write_symbol_definition(arguments, output_file, symbol_name, "height",
+                                sprite->height);
+        write_symbol_definition(arguments, output_file, symbol_name,
+                                "pixels_per_line", sprite->width_pixels);
+        write_symbol_definition(arguments, output_file, symbol_name,
+                                "bytes_per_line", sprite->width_bytes);
+
+        if (arguments->plus_sprites)
+        {
+                fprintf(output_file, "\n");
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "plus_sprites_per_line",
+                                        sprite->tiles_per_line);
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "plus_sprite_lines", sprite->tile_lines);
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "plus_sprite_count",
+                                        sprite->tiles_per_line *
+                                                sprite->tile_lines);
+        }
+
+        if (arguments->layout == LAYOUT_PUSH)
+        {
+                fprintf(output_file, "\n");
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "push_bytes_per_line",
+                                        sprite->data_bytes_per_line);
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "push_words_per_line",
+                                        sprite->data_bytes_per_line / 2);
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "push_padded_left",
+                                        sprite->padded_left);
+        }
+
+        if (arguments->explicit_palette_count > 0)
+        {
+                fprintf(output_file, "\n");
+                write_symbol_definition(arguments, output_file, symbol_name,
+                                        "palette_count",
+                                        arguments->explicit_palette_count);
+
+                for (int i = 0; i < arguments->explicit_palette_count; i++)
+                {
+                        char suffix[32];
+                        snprintf(suffix, sizeof(suffix), "palette_ink_%d", i);
+                        write_symbol_definition(arguments, output_file,
+                                                symbol_name, suffix,
+                                                arguments->explicit_palette[i]);
+                }
+        }
+}
+
+/* Screen lines of a character row are &800 apart, so a sprite drawn
+ * from screen line phase is split in blocks wherever (phase + y) % 8
+ * wraps.  Blocks are listed in output order, with their line count and
+ * offset from the start of the data. */
+void write_charblock_table(const struct arguments *arguments,
+                           FILE *output_file, const char *symbol_name,
+                           const converted_sprite *sprite)
+{
+        bool rasm = arguments->assembler == ASSEMBLER_RASM;
+        unsigned int phase = arguments->charblock_phase;
+        unsigned int block_count = (phase + sprite->height - 1) / 8 + 1;
+
+        fprintf(output_file, "\n");
+        write_symbol_definition(arguments, output_file, symbol_name,
+                                "charblock_phase", phase);
+        write_symbol_definition(arguments, output_file, symbol_name,
+                                "charblock_count", block_count);
+        fprintf(output_file,
+                rasm ? "\n%s_charblocks\n" : "\n%s_charblocks::\n",
+                symbol_name);
+
+        for (unsigned int i = 0; i < block_count; i++)
+        {
+                unsigned int block =
+                        arguments->bottom_to_top ? block_count - 1 - i : i;
+
+                /* Image rows of this block, before applying direction. */
+                int first = block == 0 ? 0 : block * 8 - phase;
+                int last = (block + 1) * 8 - phase - 1;
+                if (last >= (int)sprite->height)
+                {
+                        last = sprite->height - 1;
+                }
+
+                unsigned int first_output_row =
+                        arguments->bottom_to_top ? sprite->height - 1 - last
+                                                 : (unsigned int)first;
+
+                fprintf(output_file,
+                        rasm ? "\tdefb %d\n\tdefw #%04X\n"
+                             : "\t.byte %d\n\t.word 0x%04x\n",
+                        last - first + 1,
+                        first_output_row * sprite->data_bytes_per_line);
+        }
+
+        fprintf(output_file, rasm ? "%s_charblocks_end\n"
+                                  : "%s_charblocks_end::\n",
+                symbol_name);
+}
+
+void write_plus_palette(const struct arguments *arguments, FILE *output_file,
+                        const char *symbol_name, const converted_sprite *sprite)
+{
+        bool rasm = arguments->assembler == ASSEMBLER_RASM;
+
+        fprintf(output_file,
+                rasm ? "\n%s_plus_palette\n" : "\n%s_plus_palette::\n",
+                symbol_name);
+
+        for (int pen = 1; pen < 16; pen++)
+        {
+                fprintf(output_file,
+                        rasm ? "\tdefb #%02X, #%02X\t; pen %d\n"
+                             : "\t.byte 0x%02x, 0x%02x\t; pen %d\n",
+                        sprite->plus_palette[pen - 1][0],
+                        sprite->plus_palette[pen - 1][1], pen);
+        }
+
+        fprintf(output_file,
+                rasm ? "%s_plus_palette_end\n" : "%s_plus_palette_end::\n",
+                symbol_name);
+}
+
+void write_sdasz80_output(const struct arguments *arguments,
+                          FILE *output_file, const char *symbol_name,
+                          const char *module_name, const char *area_name,
+                          const converted_sprite *sprite)
+{
+        fprintf(output_file, ".module %s\n\n", module_name);
+
+        if (strlen(area_name))
+        {
+                fprintf(output_file, ".area %s\n\n", area_name);
+        }
+
+        write_metadata_symbols(arguments, output_file, symbol_name, sprite);
+
+        fprintf(output_file, "\n%s_data::\n", symbol_name);
+
+        {
+                for (size_t yplain = 0; yplain < sprite->height; yplain++)
+                {
+                        const u_int8_t *b = sprite_row_in_output_order(
+                                arguments, sprite, yplain);
+                        u_int8_t bytes_on_this_line = 0;
+
+                        for (size_t x = 0; x < sprite->data_bytes_per_line;
+                             x++)
+                        {
+                                u_int8_t byte = *(b++);
+
+                                if (bytes_on_this_line >= 12)
+                                {
+                                        bytes_on_this_line = 0;
+                                }
+
+                                if (bytes_on_this_line == 0)
+                                {
+                                        fprintf(output_file, "\n\t.byte ");
+                                }
+                                else
+                                {
+                                        fprintf(output_file, ", ");
+                                }
+                                bytes_on_this_line++;
+
+                                fprintf(output_file, "0x%02x", byte);
+                        }
+                }
+                fprintf(output_file, "\n");
+        }
+
+        fprintf(output_file, "\n%s_data_end::\n", symbol_name);
+
+        if (arguments->plus_sprites)
+        {
+                write_plus_palette(arguments, output_file, symbol_name, sprite);
+        }
+
+        if (arguments->charblock)
+        {
+                write_charblock_table(arguments, output_file, symbol_name,
+                                      sprite);
+        }
+}
+
+/* Leave the file, and its timestamp, alone when it already has this
+ * exact content, so that downstream make steps are not triggered for
+ * nothing. */
+void write_file_if_changed(const char *file_name, const char *buffer,
+                           size_t size)
+{
+        FILE *f = fopen(file_name, "rb");
+
+        if (f != NULL)
+        {
+                bool same = true;
+                size_t i = 0;
+                int c;
+
+                while (same && (c = fgetc(f)) != EOF)
+                {
+                        same = i < size && buffer[i++] == c;
+                }
+                fclose(f);
+
+                if (same && i == size)
+                {
+                        printf("File '%s' unchanged, not rewritten.\n",
+                               file_name);
+                        return;
+                }
+        }
+
+        f = fopen(file_name, "wb");
+
+        if (f == NULL || fwrite(buffer, 1, size, f) != size)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: error: could not write output file "
+                        "'%s'.\n",
+                        file_name);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        fclose(f);
+}
+
+/* Binary file written next to the output file, compared first like
+ * the output file itself when only changed files are written. */
+void write_binary_file(const struct arguments *arguments,
+                       const char *file_name, const u_int8_t *buffer,
+                       size_t size)
+{
+        if (arguments->write_only_if_changed)
+        {
+                write_file_if_changed(file_name, (const char *)buffer, size);
+                return;
+        }
+
+        FILE *f = fopen(file_name, "wb");
+
+        if (f == NULL || fwrite(buffer, 1, size, f) != size)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: error: could not write binary "
+                        "output file '%s'.\n",
+                        file_name);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        fclose(f);
+}
+
+/* rasm flavor: metadata as EQU, data through INCBIN of a binary file
+ * written next to the output file, so that rasm does not have to parse
+ * bytes as text. */
+void write_rasm_output(const struct arguments *arguments, FILE *output_file,
+                       const char *symbol_name, const converted_sprite *sprite)
+{
+        char *binary_file_name =
+                malloc(strlen(arguments->output_file) + sizeof(".bin"));
+        sprintf(binary_file_name, "%s.bin", arguments->output_file);
+
+        size_t binary_bytes = sprite->data_bytes_per_line * sprite->height;
+        u_int8_t *binary = malloc(binary_bytes);
+
+        for (size_t yplain = 0; yplain < sprite->height; yplain++)
+        {
+                memcpy(binary + yplain * sprite->data_bytes_per_line,
+                       sprite_row_in_output_order(arguments, sprite, yplain),
+                       sprite->data_bytes_per_line);
+        }
+
+        write_binary_file(arguments, binary_file_name, binary, binary_bytes);
+        free(binary);
+
+        printf("Finished writing binary file '%s'.\n", binary_file_name);
+
+        /* rasm resolves INCBIN relative to the including source file,
+         * which is written in the same directory. */
+        const char *binary_file_base_name = strrchr(binary_file_name, '/');
+        binary_file_base_name = binary_file_base_name == NULL
+                                        ? binary_file_name
+                                        : binary_file_base_name + 1;
+
+        fprintf(output_file, "; Generated by %s from %s\n\n",
+                argp_program_version, arguments->input_file);
+
+        write_metadata_symbols(arguments, output_file, symbol_name, sprite);
+
+        if (arguments->rasm_crunch_directive != NULL)
+        {
+                fprintf(output_file, "\n%s_data_crunched\n", symbol_name);
+                fprintf(output_file, "\t%s\n", arguments->rasm_crunch_directive);
+                fprintf(output_file, "\tINCBIN \"%s\"\n",
+                        binary_file_base_name);
+                fprintf(output_file, "\tLZCLOSE\n");
+                fprintf(output_file, "%s_data_crunched_end\n", symbol_name);
+        }
+        else
+        {
+                fprintf(output_file, "\n%s_data\n", symbol_name);
+                fprintf(output_file, "\tINCBIN \"%s\"\n",
+                        binary_file_base_name);
+                fprintf(output_file, "%s_data_end\n", symbol_name);
+        }
+
+        if (arguments->plus_sprites)
+        {
+                write_plus_palette(arguments, output_file, symbol_name, sprite);
+        }
+
+        if (arguments->charblock)
+        {
+                write_charblock_table(arguments, output_file, symbol_name,
+                                      sprite);
+        }
+
+        free(binary_file_name);
+}
+
+/* Pixels are remapped through this table, so that color matching
+ * happens once per colormap entry, not once per pixel.  Indexes that
+ * the image must not use map to INVALID_INK. */
+#define INVALID_INK 0xff
+
+void build_index_to_ink_table(struct arguments *arguments,
+                              indexed_image *image,
+                              bool palette_from_command_line,
+                              unsigned int max_color_count,
+                              u_int8_t index_to_ink[256])
+{
+        memset(index_to_ink, INVALID_INK, 256);
+
+        if (!palette_from_command_line)
+        {
+                for (unsigned int i = 0; i < max_color_count; i++)
+                {
+                        index_to_ink[i] = i;
+                }
+        }
+        else if (image->pixels_are_explicit_palette_indices)
+        {
+                for (int i = 0; i < arguments->explicit_palette_count; i++)
+                {
+                        index_to_ink[i] = i;
+                }
+        }
+        else
+        {
+                for (unsigned int i = 0; i < image->colormap_entries; i++)
+                {
+                        index_to_ink[i] =
+                                find_palette_index_closest_to_this_rgb_triplet(
+                                        arguments, image->colormap + i * 3);
+                        printf("PNG palette entry %d mapped to palette "
+                               "index %u\n",
+                               i, index_to_ink[i]);
+                }
+        }
+}
+
+#define PLUS_SPRITE_SIZE 16
+#define PLUS_SPRITE_BYTES (PLUS_SPRITE_SIZE * PLUS_SPRITE_SIZE)
+
+/* Plus palette entries are two bytes: red in the high nibble and blue
+ * in the low nibble of the first, green in the low nibble of the
+ * second. */
+void plus_palette_entry(u_int8_t r4, u_int8_t g4, u_int8_t b4,
+                        u_int8_t entry[2])
+{
+        entry[0] = r4 << 4 | b4;
+        entry[1] = g4;
+}
+
+u_int8_t rgb8_to_plus_level(u_int8_t v)
+{
+        return (v * 15 + 127) / 255;
+}
+
+/* The Plus rendering of the 3 CPC levels, as the Plus firmware does
+ * for CPC inks. */
+u_int8_t cpc_level_to_plus_level(u_int8_t v)
+{
+        return v == 0 ? 0x0 : v == 255 ? 0xf : 0x6;
+}
+
+/* Decode one PNG file and cut it into CPC Plus hardware sprites: 16x16
+ * pixels, one byte per pixel holding the pen in its low nibble, pen 0
+ * being transparent.  Sprites are in reading order, left to right then
+ * top to bottom; the image is extended with transparent pixels to a
+ * multiple of 16 in both directions. */
+converted_sprite convert_png_file_to_plus_sprites(struct arguments *arguments,
+                                                  conversion_report *report)
+{
+        bool palette_from_command_line = arguments->explicit_palette_count > 0;
+
+        indexed_image image;
+
+        printf("Will read from %s\n", arguments->input_file);
+
+        if (!decode_png_indexed(arguments->input_file, &image))
+        {
+                decode_png_simplified(arguments, &image);
+        }
+
+        {
+                struct stat input_stat;
+                if (stat(arguments->input_file, &input_stat) == 0)
+                {
+                        report->input_file_bytes = input_stat.st_size;
+                }
+        }
+
+        report_end_stage(report, "decode");
+
+        converted_sprite sprite;
+        memset(&sprite, 0, sizeof(sprite));
+
+        sprite.tiles_per_line =
+                (image.width + PLUS_SPRITE_SIZE - 1) / PLUS_SPRITE_SIZE;
+        sprite.tile_lines =
+                (image.height + PLUS_SPRITE_SIZE - 1) / PLUS_SPRITE_SIZE;
+
+        if (sprite.tiles_per_line * PLUS_SPRITE_SIZE != image.width ||
+            sprite.tile_lines * PLUS_SPRITE_SIZE != image.height)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: Warning: image is %ux%u pixels, "
+                        "extending it with transparent pixels to %ux%u.\n",
+                        image.width, image.height,
+                        sprite.tiles_per_line * PLUS_SPRITE_SIZE,
+                        sprite.tile_lines * PLUS_SPRITE_SIZE);
+        }
+
+        if (palette_from_command_line)
+        {
+                for (int pen = 1; pen < arguments->explicit_palette_count &&
+                                  pen < 16;
+                     pen++)
+                {
+                        byte_triplet rgb =
+                                cpc_palette[arguments->explicit_palette[pen]];
+                        plus_palette_entry(cpc_level_to_plus_level(rgb.r),
+                                           cpc_level_to_plus_level(rgb.g),
+                                           cpc_level_to_plus_level(rgb.b),
+                                           sprite.plus_palette[pen - 1]);
+                }
+        }
+        else
+        {
+                for (unsigned int pen = 1;
+                     pen < image.colormap_entries && pen < 16; pen++)
+                {
+                        u_int8_t *rgb = image.colormap + pen * 3;
+                        plus_palette_entry(rgb8_to_plus_level(rgb[0]),
+                                           rgb8_to_plus_level(rgb[1]),
+                                           rgb8_to_plus_level(rgb[2]),
+                                           sprite.plus_palette[pen - 1]);
+                }
+        }
+
+        report->width_pixels = sprite.tiles_per_line * PLUS_SPRITE_SIZE;
+        report->width_bytes = report->width_pixels;
+        report->height = sprite.tile_lines * PLUS_SPRITE_SIZE;
+
+        report_end_stage(report, "palette");
+
+        u_int8_t index_to_ink[256];
+        build_index_to_ink_table(arguments, &image, palette_from_command_line,
+                                 16, index_to_ink);
+
+        unsigned int tile_count = sprite.tiles_per_line * sprite.tile_lines;
+
+        sprite.data_bytes = tile_count * PLUS_SPRITE_BYTES;
+        sprite.data_bytes_per_line = PLUS_SPRITE_SIZE;
+        sprite.width_pixels = PLUS_SPRITE_SIZE;
+        sprite.width_bytes = PLUS_SPRITE_SIZE;
+        sprite.height = tile_count * PLUS_SPRITE_SIZE;
+        sprite.data = calloc(sprite.data_bytes, 1);
+
+        if (sprite.data == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: could not allocate %u bytes "
+                        "for sprite buffer",
+                        sprite.data_bytes);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
+
+        for (png_uint_32 y = 0; y < image.height; y++)
+        {
+                for (png_uint_32 x = 0; x < image.width; x++)
+                {
+                        u_int8_t png_index = indexed_image_get(&image, x, y);
+                        u_int8_t pen = index_to_ink[png_index];
+
+                        if (pen == INVALID_INK || pen > 15)
+                        {
+                                fprintf(stderr,
+                                        "Error: at pixel (%u,%u), image uses "
+                                        "palette index %d which is too high "
+                                        "for a Plus hardware sprite (>=16).  "
+                                        "Aborting.\n",
+                                        x, y, png_index);
+                                exit(1);
+                        }
+
+                        unsigned int tile =
+                                (y / PLUS_SPRITE_SIZE) * sprite.tiles_per_line +
+                                x / PLUS_SPRITE_SIZE;
+
+                        sprite.data[tile * PLUS_SPRITE_BYTES +
+                                    (y % PLUS_SPRITE_SIZE) * PLUS_SPRITE_SIZE +
+                                    x % PLUS_SPRITE_SIZE] = pen;
+                }
+        }
+
+        report_add_variant(report, "plus_sprites", sprite.data_bytes);
+        report_end_stage(report, "convert");
+
+        return sprite;
+}
+
+/* Decode one PNG file and convert it to CPC sprite data.  Mode
+ * guessing and palette generation update *arguments, as they describe
+ * what the generated symbols will be. */
+converted_sprite convert_png_file(struct arguments *arguments,
+                                  conversion_report *report)
+{
+        bool palette_from_command_line = arguments->explicit_palette_count > 0;
+
+        indexed_image image;
+
+        printf("Will read from %s\n", arguments->input_file);
+
+        if (!decode_png_indexed(arguments->input_file, &image))
+        {
+                decode_png_simplified(arguments, &image);
+        }
+
+        {
+                struct stat input_stat;
+                if (stat(arguments->input_file, &input_stat) == 0)
+                {
+                        report->input_file_bytes = input_stat.st_size;
+                }
+        }
+
+        report_end_stage(report, "decode");
+
+        printf("Finished decoding PNG. Processing.\n");
+
+        if (!arguments->crtc_mode_explicitly_set)
+        {
+                printf("CRTC mode not determined by command line.\n");
+                if (arguments->explicit_palette_count > 0)
+                {
+                        printf("Guessing from command-line colormap count (%u "
+                               "entries).\n",
+                               arguments->explicit_palette_count);
+                        arguments->crtc_mode =
+                                guess_crtc_mode_based_on_colormap_entry_count(
+                                        arguments->explicit_palette_count);
+
+                        if (arguments->crtc_mode == 4)
+                        {
+                                fprintf(stderr,
+                                        "Internal error: "
+                                        "guess_crtc_mode_based_on_colormap_"
+                                        "entry_count returned an unexpected "
+                                        "value.  Too many explicit palette "
+                                        "entries (%u)?\n",
+                                        arguments->explicit_palette_count);
+                                exit(1);
+                        }
+                }
+                else
+                {
+                        printf("Guessing from image colormap count (%u "
+                               "entries).\n",
+                               image.colormap_entries);
+                        arguments->crtc_mode =
+                                guess_crtc_mode_based_on_colormap_entry_count(
+                                        image.colormap_entries);
+                        if (arguments->crtc_mode == 4)
+                        {
+                                fprintf(stderr,
+                                        "Error: the PNG palette has too many "
+                                        "colors (%u) for the CPC, "
+                                        "not trying to guess "
+                                        "mode.  Please prepare the picture for "
+                                        "the CPC.  In the "
+                                        "special case where your picture is "
+                                        "indeed prepared, actually "
+                                        "uses the first indices of the palette "
+                                        "only and only happens "
+                                        "to have extraneous colormap entries "
+                                        "at PNG level, set mode "
+                                        "explicitly, for example: -mode 1 .\n",
+                                        image.colormap_entries);
+                                exit(1);
+                        }
+                }
+        }
+
+        unsigned int max_color_count_for_selected_mode =
+                max_color_count_for_mode(arguments->crtc_mode);
+
+        printf("CRTC mode selected: %u, which means a palette of %u colors.\n",
+               arguments->crtc_mode, max_color_count_for_selected_mode);
+
+        if (arguments->explicit_palette_count == 0)
+        {
+                printf("No palette provided on command line.  Assuming that "
+                       "your nicely prepared your PNG with a "
+                       "nice palette specially for the CPC.   Will map RGB "
+                       "information from PNG image to CPC colors.\n");
+
+                u_int8_t entries_in_generated_cpc_palette =
+                        image.colormap_entries;
+
+                if (image.colormap_entries > max_color_count_for_selected_mode)
+                {
+                        fprintf(stderr,
                                 "png2cpcsprite: Warning: colormap size is %u, "
                                 "which is more than the %u, the maximum "
                                 "allowed for CPC mode %u.  Since we are in "
@@ -845,386 +2212,1144 @@ int main(int argc, const char **argv)
                                 "index %d or above, so moving along.\n",
                                 image.colormap_entries,
                                 max_color_count_for_selected_mode,
-                                arguments.crtc_mode,
+                                arguments->crtc_mode,
                                 max_color_count_for_selected_mode);
 
-                        entries_in_generated_cpc_palette =
-                                max_color_count_for_selected_mode;
+                        entries_in_generated_cpc_palette =
+                                max_color_count_for_selected_mode;
+                }
+
+                u_int8_t *cmap_p = image.colormap;
+
+                for (png_uint_32 cmap_i = 0;
+                     cmap_i < entries_in_generated_cpc_palette; cmap_i++)
+                {
+                        // FIXME Should check if really 3 components? Or
+                        // guaranteed by read parameters?
+                        int png_cmap_r = *(cmap_p++);
+                        int png_cmap_g = *(cmap_p++);
+                        int png_cmap_b = *(cmap_p++);
+
+                        unsigned int squared_distance_min = ~0;
+                        unsigned int squared_distance_min_index = ~0;
+
+                        for (int cpc_full_palette_index = 0;
+                             cpc_full_palette_index < 27;
+                             cpc_full_palette_index++)
+                        {
+                                byte_triplet candidate_rgb =
+                                        cpc_palette[cpc_full_palette_index];
+
+                                int dr = png_cmap_r - candidate_rgb.r;
+                                int dg = png_cmap_g - candidate_rgb.g;
+                                int db = png_cmap_b - candidate_rgb.b;
+
+                                unsigned int squared_distance =
+                                        (dr * dr + dg * dg + db * db);
+
+                                if (squared_distance < squared_distance_min)
+                                {
+                                        squared_distance_min_index =
+                                                cpc_full_palette_index;
+                                        squared_distance_min = squared_distance;
+
+                                        if (squared_distance == 0)
+                                        {
+                                                break;
+                                        }
+                                }
+                        }
+
+                        arguments->explicit_palette
+                                [arguments->explicit_palette_count++] =
+                                squared_distance_min_index;
+
+                        printf("PNG palette entry %d (r,g,b)=(%u,%u,%u) mapped "
+                               "to CPC color %u\n",
+                               cmap_i, png_cmap_r, png_cmap_g, png_cmap_b,
+                               squared_distance_min_index);
+                }
+
+                if (entries_in_generated_cpc_palette < image.colormap_entries)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: Warning: generated CPC palette "
+                                "has only %d entries instead of the original "
+                                "%d.  Assuming the remaining %d are not used "
+                                "at all in the input image, else will abort.  "
+                                "If this is not what you meant, check the -p "
+                                "option.\n",
+                                entries_in_generated_cpc_palette,
+                                image.colormap_entries,
+                                image.colormap_entries -
+                                        entries_in_generated_cpc_palette);
+                }
+        }
+
+        unsigned int width_bytes = image.width >> (arguments->crtc_mode + 1);
+
+        unsigned int width_pixels = width_bytes << (arguments->crtc_mode + 1);
+
+        if (width_pixels != image.width)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: Error: in the selected CPC mode %u, "
+                        "image width %u pixels turns into %u bytes which will "
+                        "expand to %u pixels, not %u.",
+                        arguments->crtc_mode, image.width, width_bytes,
+                        width_pixels, image.width);
+                exit(1);
+        }
+
+        if (arguments->layout == LAYOUT_PUSH && (width_bytes & 1) &&
+            arguments->pad_odd_width == PAD_NONE)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: Error: push layout needs an even "
+                        "number of bytes per line, got %u.  "
+                        "See --pad_odd_width.\n",
+                        width_bytes);
+                exit(1);
+        }
+
+        unsigned int sprite_bytes = width_bytes * image.height;
+
+        report->width_pixels = width_pixels;
+        report->width_bytes = width_bytes;
+        report->height = image.height;
+
+        report_end_stage(report, "palette");
+
+        printf("\nWill generate a sprite representation for CRTC mode %u, "
+               "width "
+               "%u pixels (%u bytes), height %u lines, total %u bytes.\n",
+               arguments->crtc_mode, image.width, width_bytes, image.height,
+               sprite_bytes);
+
+        u_int8_t index_to_ink[256];
+        build_index_to_ink_table(arguments, &image, palette_from_command_line,
+                                 max_color_count_for_selected_mode,
+                                 index_to_ink);
+
+        u_int8_t *sprite_buffer;
+        {
+                sprite_buffer = malloc(sprite_bytes);
+
+                if (sprite_buffer == NULL)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: could not allocate %u bytes "
+                                "for sprite buffer",
+                                sprite_bytes);
+                        // Yes, we don't cleanup.  Quick and dirty!
+                        exit(1);
                 }
+        }
 
-                u_int8_t *cmap_p = buffer_for_colormap;
+        {
+                u_int8_t *w = sprite_buffer;
+                int pixels_per_byte = 2 << arguments->crtc_mode;
 
-                for (png_uint_32 cmap_i = 0;
-                     cmap_i < entries_in_generated_cpc_palette; cmap_i++)
+                for (png_uint_32 y = 0; y < image.height; y++)
                 {
-                        // FIXME Should check if really 3 components? Or
-                        // guaranteed by read parameters?
-                        int png_cmap_r = *(cmap_p++);
-                        int png_cmap_g = *(cmap_p++);
-                        int png_cmap_b = *(cmap_p++);
+                        png_uint_32 x = 0;
 
-                        unsigned int squared_distance_min = ~0;
-                        unsigned int squared_distance_min_index = ~0;
+                        for (unsigned int xbyte = 0; xbyte < width_bytes;
+                             xbyte++)
+                        {
+                                u_int8_t cpc_byte = 0;
 
-                        for (int cpc_full_palette_index = 0;
-                             cpc_full_palette_index < 27;
-                             cpc_full_palette_index++)
+                                for (int pixel_in_byte = 0;
+                                     pixel_in_byte < pixels_per_byte;
+                                     pixel_in_byte++, x++)
+                                {
+                                        u_int8_t png_index =
+                                                indexed_image_get(&image, x, y);
+                                        u_int8_t color_palette_index =
+                                                index_to_ink[png_index];
+
+                                        if (color_palette_index == INVALID_INK)
+                                        {
+                                                fprintf(stderr,
+                                                        "Error: at pixel "
+                                                        "number %lu, image "
+                                                        "uses palette index %d "
+                                                        "which is too high "
+                                                        "(>=%u) for this mode "
+                                                        "of operation "
+                                                        "(straight "
+                                                        "PNG-palette-index-to-"
+                                                        "CPC-palette-index) "
+                                                        "and CPC mode %d.  "
+                                                        "Result would most "
+                                                        "certainly be ugly.  "
+                                                        "Please prepare your "
+                                                        "image for the CPC "
+                                                        "beforehand or see -p "
+                                                        "option.\n"
+                                                        "Aborting.\n",
+                                                        (size_t)y * image.width +
+                                                                x,
+                                                        png_index,
+                                                        max_color_count_for_selected_mode,
+                                                        arguments->crtc_mode);
+                                                exit(1);
+                                        }
+
+                                        cpc_byte = cpc_byte << 1;
+
+                                        switch (arguments->crtc_mode)
+                                        {
+                                        case 0:
+                                                cpc_byte |=
+                                                        (color_palette_index & 8) >> 3 |
+                                                        (color_palette_index & 4) << 2 |
+                                                        (color_palette_index & 2) << 1 |
+                                                        (color_palette_index & 1) << 6;
+                                                break;
+                                        case 1:
+                                                cpc_byte |=
+                                                        (color_palette_index & 2) >> 1 |
+                                                        (color_palette_index & 1) << 4;
+                                                break;
+                                        case 2:
+                                                cpc_byte |= color_palette_index;
+                                                break;
+                                        default:
+                                                fprintf(stderr,
+                                                        "png2cpcsprite: "
+                                                        "internal error: are "
+                                                        "we really supposed "
+                                                        "to do mode %d?\n",
+                                                        arguments->crtc_mode);
+                                                // Yes, we don't cleanup.
+                                                // Quick and dirty!
+                                                exit(1);
+                                        }
+                                }
+                                *w = cpc_byte;
+                                w++;
+                        }
+                }
+
+                if (w != sprite_buffer + sprite_bytes)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: warning: did not produce "
+                                "exacly the expected %u bytes of sprite data, "
+                                "actually %lu (%p != %p).\n",
+                                sprite_bytes, w - sprite_buffer, w,
+                                sprite_buffer + sprite_bytes);
+                }
+        }
+
+        converted_sprite sprite = {
+                .data = sprite_buffer,
+                .data_bytes = sprite_bytes,
+                .data_bytes_per_line = width_bytes,
+                .width_pixels = width_pixels,
+                .width_bytes = width_bytes,
+                .height = image.height,
+                .padded_left = false,
+        };
+
+        report_add_variant(report, "data", sprite_bytes);
+
+        if (arguments->layout == LAYOUT_PUSH)
+        {
+                sprite = arrange_for_push(arguments, &sprite);
+                free(sprite_buffer);
+                report_add_variant(report, "push", sprite.data_bytes);
+        }
+
+        report_end_stage(report, "convert");
+
+        return sprite;
+}
+
+/* Generate a valid assembler symbol part from the file part of a
+ * path, replacing invalid characters with an underscore. */
+char *name_stem_from_file_name(const char *file_name)
+{
+        const char *last_part_of_input_file_name = strrchr(file_name, '/');
+        if (last_part_of_input_file_name == NULL)
+        {
+                last_part_of_input_file_name = file_name;
+        }
+        else
+        {
+                last_part_of_input_file_name++;
+        }
+
+        char *auto_name_stem = strdup(last_part_of_input_file_name);
+
+        /*
+          From
+     cpc-dev-tool-chain/tool/sdcc/sdcc-3.9.0/sdas/doc/asmlnk.txt
+
+     1.  Symbols  can  be  composed  of alphanumeric characters,
+         dollar signs ($),  periods  (.),  and  underscores  (_)
+         only.
+
+     2.  The  first  character  of a symbol must not be a number
+         (except in the case of reusable symbols).
+
+         */
+
+        char *auto_name_stem_end = auto_name_stem + strlen(auto_name_stem);
+
+        const char *valid_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghij"
+                                  "klmnopqrstuvwxyz0123456789_";
+
+        {
+                char *p = auto_name_stem;
+                while (p != auto_name_stem_end)
+                {
+                        size_t advance = strspn(p, valid_chars);
+                        p += advance;
+                        if ((*p) != 0)
                         {
-                                byte_triplet candidate_rgb =
-                                        cpc_palette[cpc_full_palette_index];
+                                *p = '_';
+                        }
+                }
+        }
 
-                                int dr = png_cmap_r - candidate_rgb.r;
-                                int dg = png_cmap_g - candidate_rgb.g;
-                                int db = png_cmap_b - candidate_rgb.b;
+        return auto_name_stem;
+}
 
-                                unsigned int squared_distance =
-                                        (dr * dr + dg * dg + db * db);
+#define MAX_STRINGS_SIZE 255
 
-                                if (squared_distance < squared_distance_min)
-                                {
-                                        squared_distance_min_index =
-                                                cpc_full_palette_index;
-                                        squared_distance_min = squared_distance;
+#define ATLAS_PAGE_BYTES 256
+#define ATLAS_BANK_PAGES 64
+#define ATLAS_BANK_BYTES (ATLAS_PAGE_BYTES * ATLAS_BANK_PAGES)
+#define ATLAS_MAX_BANKS 16
+
+typedef struct atlas_entry
+{
+        char symbol_name[MAX_STRINGS_SIZE];
+        converted_sprite sprite;
+        unsigned int rows_per_page;
+        unsigned int pages;
+        unsigned int bank;
+        unsigned int offset;
+} atlas_entry;
+
+/* Pages are numbered across banks: page p belongs to bank
+ * p / ATLAS_BANK_PAGES.  page_fill tells how many bytes are used at
+ * the start of each page.  The palette is that of the first sprite,
+ * only used for the palette symbols of the atlas. */
+typedef struct atlas
+{
+        atlas_entry entries[MAX_ATLAS_SPRITES];
+        int entry_count;
+        int crtc_mode;
+        unsigned int palette[MAX_EXPLICIT_PALETTE_COUNT];
+        int palette_count;
+        unsigned int page_fill[ATLAS_MAX_BANKS * ATLAS_BANK_PAGES];
+        unsigned int pages_used;
+        u_int8_t data[ATLAS_MAX_BANKS * ATLAS_BANK_BYTES];
+} atlas;
+
+/* Copy rows of a sprite, in output order, to consecutive lines of
+ * the atlas starting at atlas byte "position". */
+void atlas_copy_rows(const struct arguments *arguments, atlas *atlas,
+                     const atlas_entry *entry, unsigned int first_row,
+                     unsigned int row_count, unsigned int position)
+{
+        const converted_sprite *sprite = &entry->sprite;
+
+        for (unsigned int row = 0; row < row_count; row++)
+        {
+                memcpy(atlas->data + position +
+                               row * sprite->data_bytes_per_line,
+                       sprite_row_in_output_order(arguments, sprite,
+                                                  first_row + row),
+                       sprite->data_bytes_per_line);
+        }
+}
+
+/* A sprite that fits in a page goes to the first page with enough
+ * room left.  A bigger one is cut into chunks of rows_per_page rows,
+ * each chunk at the start of its own page, in consecutive pages of a
+ * single bank. */
+void atlas_place(const struct arguments *arguments, atlas *atlas,
+                 atlas_entry *entry)
+{
+        const converted_sprite *sprite = &entry->sprite;
+        unsigned int total_pages = ATLAS_MAX_BANKS * ATLAS_BANK_PAGES;
+        unsigned int page;
+
+        if (entry->pages == 1)
+        {
+                for (page = 0; page < total_pages; page++)
+                {
+                        if (ATLAS_PAGE_BYTES - atlas->page_fill[page] >=
+                            sprite->data_bytes)
+                        {
+                                break;
+                        }
+                }
+        }
+        else
+        {
+                for (page = 0; page + entry->pages <= total_pages; page++)
+                {
+                        unsigned int last = page + entry->pages - 1;
+                        bool pages_free = page / ATLAS_BANK_PAGES ==
+                                          last / ATLAS_BANK_PAGES;
+
+                        for (unsigned int p = page; pages_free && p <= last;
+                             p++)
+                        {
+                                pages_free = atlas->page_fill[p] == 0;
+                        }
+
+                        if (pages_free)
+                        {
+                                break;
+                        }
+                }
+        }
+
+        if (page + entry->pages > total_pages)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: Error: atlas is full (%u banks) when "
+                        "placing '%s'.\n",
+                        ATLAS_MAX_BANKS, entry->symbol_name);
+                exit(1);
+        }
+
+        entry->bank = page / ATLAS_BANK_PAGES;
+        entry->offset = (page % ATLAS_BANK_PAGES) * ATLAS_PAGE_BYTES +
+                        atlas->page_fill[page];
+
+        for (unsigned int chunk = 0; chunk < entry->pages; chunk++)
+        {
+                unsigned int first_row = chunk * entry->rows_per_page;
+                unsigned int row_count = sprite->height - first_row;
+                if (row_count > entry->rows_per_page)
+                {
+                        row_count = entry->rows_per_page;
+                }
+
+                unsigned int p = page + chunk;
+
+                atlas_copy_rows(arguments, atlas, entry, first_row, row_count,
+                                p * ATLAS_PAGE_BYTES + atlas->page_fill[p]);
+
+                atlas->page_fill[p] +=
+                        row_count * sprite->data_bytes_per_line;
+
+                if (p + 1 > atlas->pages_used)
+                {
+                        atlas->pages_used = p + 1;
+                }
+        }
+}
+
+/* Bytes from the start of the atlas to the end of the data in its
+ * last used page. */
+unsigned int atlas_data_bytes(const atlas *atlas)
+{
+        if (atlas->pages_used == 0)
+        {
+                return 0;
+        }
+
+        return (atlas->pages_used - 1) * ATLAS_PAGE_BYTES +
+               atlas->page_fill[atlas->pages_used - 1];
+}
+
+int compare_atlas_entries_by_decreasing_size(const void *a, const void *b)
+{
+        const atlas_entry *ea = *(const atlas_entry **)a;
+        const atlas_entry *eb = *(const atlas_entry **)b;
+
+        if (ea->pages != eb->pages)
+        {
+                return (int)eb->pages - (int)ea->pages;
+        }
+        if (ea->sprite.data_bytes != eb->sprite.data_bytes)
+        {
+                return (int)eb->sprite.data_bytes - (int)ea->sprite.data_bytes;
+        }
+        /* Keep command-line order otherwise, qsort is not stable. */
+        return ea < eb ? -1 : ea > eb;
+}
+
+/* Convert every input file and pack them.  Multi-page sprites are
+ * placed first so that the space they leave at the end of their last
+ * page can be filled by smaller ones. */
+void atlas_build(const struct arguments *arguments, atlas *atlas,
+                 conversion_report *report)
+{
+        atlas_entry *order[MAX_ATLAS_SPRITES];
+
+        for (int i = 0; i < arguments->atlas_input_file_count; i++)
+        {
+                atlas_entry *entry = &atlas->entries[atlas->entry_count++];
+                /* Each sprite from the command-line arguments as they
+                 * are: conversion fills in the palette and mode it
+                 * found, which must not leak into the next sprite. */
+                struct arguments sprite_arguments = *arguments;
+                conversion_report sprite_report;
+                memset(&sprite_report, 0, sizeof(sprite_report));
+                report_start_stage(&sprite_report);
+
+                sprite_arguments.input_file = arguments->atlas_input_files[i];
+                entry->sprite =
+                        convert_png_file(&sprite_arguments, &sprite_report);
+
+                if (i == 0)
+                {
+                        atlas->crtc_mode = sprite_arguments.crtc_mode;
+                        memcpy(atlas->palette,
+                               sprite_arguments.explicit_palette,
+                               sizeof(atlas->palette));
+                        atlas->palette_count =
+                                sprite_arguments.explicit_palette_count;
+                }
+                else if (atlas->crtc_mode != sprite_arguments.crtc_mode)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: Error: '%s' is converted for "
+                                "CRTC mode %u, but previous atlas sprites "
+                                "for mode %d.  Consider -m option.\n",
+                                sprite_arguments.input_file,
+                                sprite_arguments.crtc_mode, atlas->crtc_mode);
+                        exit(1);
+                }
+
+                char *name_stem =
+                        name_stem_from_file_name(sprite_arguments.input_file);
+                snprintf(entry->symbol_name, MAX_STRINGS_SIZE,
+                         arguments->symbol_format_string, name_stem);
+                free(name_stem);
+
+                unsigned int line_bytes = entry->sprite.data_bytes_per_line;
+
+                if (line_bytes > ATLAS_PAGE_BYTES)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: Error: '%s' has %u bytes per "
+                                "line, more than a %u-byte page.\n",
+                                sprite_arguments.input_file, line_bytes,
+                                ATLAS_PAGE_BYTES);
+                        exit(1);
+                }
+
+                entry->rows_per_page = ATLAS_PAGE_BYTES / line_bytes;
+                entry->pages =
+                        (entry->sprite.height + entry->rows_per_page - 1) /
+                        entry->rows_per_page;
+
+                if (entry->pages > ATLAS_BANK_PAGES)
+                {
+                        fprintf(stderr,
+                                "png2cpcsprite: Error: '%s' needs %u pages, "
+                                "more than a %u-page bank.\n",
+                                sprite_arguments.input_file, entry->pages,
+                                ATLAS_BANK_PAGES);
+                        exit(1);
+                }
+
+                report->input_file_bytes += sprite_report.input_file_bytes;
+                order[i] = entry;
+        }
+
+        report_end_stage(report, "convert");
+
+        qsort(order, atlas->entry_count, sizeof(order[0]),
+              compare_atlas_entries_by_decreasing_size);
+
+        for (int i = 0; i < atlas->entry_count; i++)
+        {
+                atlas_place(arguments, atlas, order[i]);
+        }
+
+        report_end_stage(report, "pack");
+}
+
+/* Emit a page-aligned 8-bit table with one entry per atlas sprite. */
+void write_atlas_table(const struct arguments *arguments, FILE *output_file,
+                       const char *atlas_symbol_name, const char *suffix,
+                       const atlas *atlas, int shift, bool bank)
+{
+        bool rasm = arguments->assembler == ASSEMBLER_RASM;
+
+        fprintf(output_file,
+                rasm ? "\n\talign 256\n%s_%s\n" : "\n\t.bndry 256\n%s_%s::\n",
+                atlas_symbol_name, suffix);
+
+        for (int i = 0; i < atlas->entry_count; i++)
+        {
+                const atlas_entry *entry = &atlas->entries[i];
+                unsigned int value =
+                        bank ? entry->bank : (entry->offset >> shift) & 0xff;
+
+                fprintf(output_file,
+                        i % 12 ? ", " : (rasm ? "\n\tdefb " : "\n\t.byte "));
+                fprintf(output_file, rasm ? "#%02X" : "0x%02x", value);
+        }
+        fprintf(output_file, "\n");
+}
+
+void write_atlas_output(const struct arguments *arguments, FILE *output_file,
+                        const char *atlas_symbol_name, const char *module_name,
+                        const char *area_name, const atlas *atlas)
+{
+        bool rasm = arguments->assembler == ASSEMBLER_RASM;
+        unsigned int atlas_bytes = atlas_data_bytes(atlas);
+
+        if (rasm)
+        {
+                fprintf(output_file, "; Generated by %s\n\n",
+                        argp_program_version);
+        }
+        else
+        {
+                fprintf(output_file, ".module %s\n\n", module_name);
+
+                if (strlen(area_name))
+                {
+                        fprintf(output_file, ".area %s\n\n", area_name);
+                }
+        }
+
+        write_symbol_definition(arguments, output_file, atlas_symbol_name,
+                                "bytes", atlas_bytes);
+        write_symbol_definition(arguments, output_file, atlas_symbol_name,
+                                "bank_count",
+                                (atlas->pages_used + ATLAS_BANK_PAGES - 1) /
+                                        ATLAS_BANK_PAGES);
+        write_symbol_definition(arguments, output_file, atlas_symbol_name,
+                                "sprite_count", atlas->entry_count);
+
+        if (atlas->palette_count > 0)
+        {
+                fprintf(output_file, "\n");
+                write_symbol_definition(arguments, output_file,
+                                        atlas_symbol_name, "palette_count",
+                                        atlas->palette_count);
+
+                for (int i = 0; i < atlas->palette_count; i++)
+                {
+                        char suffix[32];
+                        snprintf(suffix, sizeof(suffix), "palette_ink_%d", i);
+                        write_symbol_definition(arguments, output_file,
+                                                atlas_symbol_name, suffix,
+                                                atlas->palette[i]);
+                }
+        }
+
+        for (int i = 0; i < atlas->entry_count; i++)
+        {
+                const atlas_entry *entry = &atlas->entries[i];
+                const char *name = entry->symbol_name;
+
+                fprintf(output_file, "\n");
+                write_symbol_definition(arguments, output_file, name, "index",
+                                        i);
+                write_symbol_definition(arguments, output_file, name, "bytes",
+                                        entry->sprite.data_bytes);
+                write_symbol_definition(arguments, output_file, name, "height",
+                                        entry->sprite.height);
+                write_symbol_definition(arguments, output_file, name,
+                                        "pixels_per_line",
+                                        entry->sprite.width_pixels);
+                write_symbol_definition(arguments, output_file, name,
+                                        "bytes_per_line",
+                                        entry->sprite.width_bytes);
+                write_symbol_definition(arguments, output_file, name,
+                                        "rows_per_page", entry->rows_per_page);
+                write_symbol_definition(arguments, output_file, name, "bank",
+                                        entry->bank);
+                write_symbol_definition(arguments, output_file, name, "offset",
+                                        entry->offset);
+        }
+
+        if (rasm)
+        {
+                char *binary_file_name = malloc(strlen(arguments->output_file) +
+                                                sizeof(".bin"));
+                sprintf(binary_file_name, "%s.bin", arguments->output_file);
+
+                write_binary_file(arguments, binary_file_name, atlas->data,
+                                  atlas_bytes);
+
+                const char *binary_file_base_name =
+                        strrchr(binary_file_name, '/');
+                binary_file_base_name = binary_file_base_name == NULL
+                                                ? binary_file_name
+                                                : binary_file_base_name + 1;
+
+                fprintf(output_file, "\n\talign 256\n%s_data\n",
+                        atlas_symbol_name);
+                fprintf(output_file, "\tINCBIN \"%s\"\n",
+                        binary_file_base_name);
+                fprintf(output_file, "%s_data_end\n", atlas_symbol_name);
+
+                free(binary_file_name);
+        }
+        else
+        {
+                fprintf(output_file, "\n\t.bndry 256\n%s_data::\n",
+                        atlas_symbol_name);
+
+                for (unsigned int i = 0; i < atlas_bytes; i++)
+                {
+                        fprintf(output_file, i % 16 ? ", " : "\n\t.byte ");
+                        fprintf(output_file, "0x%02x", atlas->data[i]);
+                }
+
+                fprintf(output_file, "\n\n%s_data_end::\n", atlas_symbol_name);
+        }
 
-                                        if (squared_distance == 0)
-                                        {
-                                                break;
-                                        }
-                                }
-                        }
+        /* After the atlas label, so that no assembler sees a forward
+         * reference. */
+        fprintf(output_file, "\n");
+        for (int i = 0; i < atlas->entry_count; i++)
+        {
+                const atlas_entry *entry = &atlas->entries[i];
 
-                        arguments.explicit_palette
-                                [arguments.explicit_palette_count++] =
-                                squared_distance_min_index;
+                fprintf(output_file,
+                        rasm ? "%s_data EQU %s_data + #%04X\n"
+                             : "%s_data == %s_data + 0x%04x\n",
+                        entry->symbol_name, atlas_symbol_name,
+                        entry->bank * ATLAS_BANK_BYTES + entry->offset);
+        }
 
-                        printf("PNG palette entry %d (r,g,b)=(%u,%u,%u) mapped "
-                               "to CPC color %u\n",
-                               cmap_i, png_cmap_r, png_cmap_g, png_cmap_b,
-                               squared_distance_min_index);
-                }
+        write_atlas_table(arguments, output_file, atlas_symbol_name,
+                          "offset_low", atlas, 0, false);
+        write_atlas_table(arguments, output_file, atlas_symbol_name,
+                          "offset_high", atlas, 8, false);
+        write_atlas_table(arguments, output_file, atlas_symbol_name, "bank",
+                          atlas, 0, true);
+}
 
-                if (entries_in_generated_cpc_palette < image.colormap_entries)
+/* Whole processing for one output file, as requested on the command
+ * line. */
+void convert_and_write(struct arguments *arguments)
+{
+        conversion_report report;
+        memset(&report, 0, sizeof(report));
+        report_start_stage(&report);
+
+        if (arguments->explicit_palette_count > 0)
+        {
+                printf("Explicit palette provided with %d entries:",
+                       arguments->explicit_palette_count);
+
+                for (int i = 0; i < arguments->explicit_palette_count; i++)
                 {
-                        fprintf(stderr,
-                                "png2cpcsprite: Warning: generated CPC palette "
-                                "has only %d entries instead of the original "
-                                "%d.  Assuming the remaining %d are not used "
-                                "at all in the input image, else will abort.  "
-                                "If this is not what you meant, check the -p "
-                                "option.\n",
-                                entries_in_generated_cpc_palette,
-                                image.colormap_entries,
-                                image.colormap_entries -
-                                        entries_in_generated_cpc_palette);
+                        printf(" %d", arguments->explicit_palette[i]);
                 }
+                printf("\n");
+        }
+        else
+        {
+                printf("Explicit palette not provided.\n");
         }
 
-        unsigned int width_bytes = image.width >> (arguments.crtc_mode + 1);
-
-        unsigned int width_pixels = width_bytes << (arguments.crtc_mode + 1);
-
-        if (width_pixels != image.width)
+        if (!arguments->name_stem)
         {
-                fprintf(stderr,
-                        "png2cpcsprite: Error: in the selected CPC mode %u, "
-                        "image width %u pixels turns into %u bytes which will "
-                        "expand to %u pixels, not %u.",
-                        arguments.crtc_mode, image.width, width_bytes,
-                        width_pixels, image.width);
-                exit(1);
+                printf("No name stem supplied on command line.\n");
+
+                arguments->name_stem = name_stem_from_file_name(
+                        arguments->atlas ? arguments->output_file
+                                        : arguments->input_file);
         }
 
-        unsigned int sprite_bytes = width_bytes * image.height;
+        printf("Will use symbol name '%s'\n", arguments->name_stem);
 
-        printf("\nWill generate a sprite representation for CRTC mode %u, "
-               "width "
-               "%u pixels (%u bytes), height %u lines, total %u bytes.\n",
-               arguments.crtc_mode, image.width, width_bytes, image.height,
-               sprite_bytes);
+        char symbol_name[MAX_STRINGS_SIZE];
+        snprintf(symbol_name, MAX_STRINGS_SIZE, arguments->symbol_format_string,
+                 arguments->name_stem);
 
-        u_int8_t *sprite_buffer;
-        {
-                sprite_buffer = malloc(sprite_bytes);
+        char module_name[MAX_STRINGS_SIZE];
+        snprintf(module_name, MAX_STRINGS_SIZE, arguments->module_format_string,
+                 arguments->name_stem);
+
+        char area_name[MAX_STRINGS_SIZE];
+        snprintf(area_name, MAX_STRINGS_SIZE, arguments->area_format_string,
+                 arguments->name_stem);
 
-                if (buffer == NULL)
+        atlas *atlas = NULL;
+        converted_sprite sprite;
+
+        if (arguments->atlas)
+        {
+                atlas = calloc(1, sizeof(*atlas));
+                if (atlas == NULL)
                 {
                         fprintf(stderr,
-                                "png2cpcsprite: could not allocate %u bytes "
-                                "for sprite buffer",
-                                sprite_bytes);
+                                "png2cpcsprite: could not allocate atlas");
                         // Yes, we don't cleanup.  Quick and dirty!
                         exit(1);
                 }
-        }
 
+                atlas_build(arguments, atlas, &report);
+
+                printf("\nPacked %d sprites in %u pages, will write them "
+                       "to output file '%s'.\n",
+                       atlas->entry_count, atlas->pages_used,
+                       arguments->output_file);
+
+                report_add_variant(&report, "atlas",
+                                   atlas_data_bytes(atlas));
+        }
+        else
         {
-                u_int8_t *pixeldata = buffer;
-                u_int8_t *w = sprite_buffer;
-                for (size_t counter = 0; counter < sprite_bytes; counter++)
-                {
-                        u_int8_t cpc_byte = 0;
+                sprite = arguments->plus_sprites
+                                 ? convert_png_file_to_plus_sprites(arguments,
+                                                                    &report)
+                                 : convert_png_file(arguments, &report);
+
+                printf("\nGenerated %u bytes of sprite data, will write them "
+                       "to output "
+                       "file '%s'.\n",
+                       sprite.data_bytes, arguments->output_file);
+        }
 
-                        int pixels_per_byte = 2 << arguments.crtc_mode;
+        char *output_buffer = NULL;
+        size_t output_size = 0;
+        FILE *output_file =
+                arguments->write_only_if_changed
+                        ? open_memstream(&output_buffer, &output_size)
+                        : fopen(arguments->output_file, "w");
 
-                        for (int pixel_in_byte = 0;
-                             pixel_in_byte < pixels_per_byte; pixel_in_byte++)
-                        {
-                                u_int8_t color_palette_index;
+        if (output_file == NULL)
+        {
+                fprintf(stderr,
+                        "png2cpcsprite: error: could not open output "
+                        "file "
+                        "'%s'.",
+                        arguments->output_file);
+                // Yes, we don't cleanup.  Quick and dirty!
+                exit(1);
+        }
 
-                                if (PNG_FORMAT_FLAG_COLORMAP & image.format)
-                                {
-                                        color_palette_index = *pixeldata;
+        if (atlas != NULL)
+        {
+                write_atlas_output(arguments, output_file, symbol_name,
+                                   module_name, area_name, atlas);
+        }
+        else if (arguments->assembler == ASSEMBLER_RASM)
+        {
+                write_rasm_output(arguments, output_file, symbol_name,
+                                  &sprite);
+        }
+        else
+        {
+                write_sdasz80_output(arguments, output_file, symbol_name,
+                                     module_name, area_name, &sprite);
+        }
 
-                                        if (color_palette_index >=
-                                            max_color_count_for_selected_mode)
-                                        {
-                                                fprintf(stderr,
-                                                        "Error: at pixel "
-                                                        "number %lu, image "
-                                                        "uses palette index %d "
-                                                        "which is too high "
-                                                        "(>=%u) for this mode "
-                                                        "of operation "
-                                                        "(straight "
-                                                        "PNG-palette-index-to-"
-                                                        "CPC-palette-index) "
-                                                        "and CPC mode %d.  "
-                                                        "Result would most "
-                                                        "certainly be ugly.  "
-                                                        "Please prepare your "
-                                                        "image for the CPC "
-                                                        "beforehand or see -p "
-                                                        "option.\n"
-                                                        "Aborting.\n",
-                                                        counter,
-                                                        color_palette_index,
-                                                        max_color_count_for_selected_mode,
-                                                        arguments.crtc_mode);
-                                                exit(1);
-                                        }
+        fclose(output_file);
 
-                                        pixeldata++;
-                                }
-                                else
-                                {
-                                        color_palette_index =
-                                                find_palette_index_closest_to_this_rgb_triplet(
-                                                        &arguments, pixeldata);
-                                        pixeldata += PNG_IMAGE_SAMPLE_SIZE(
-                                                image.format);
-                                }
+        if (arguments->write_only_if_changed)
+        {
+                write_file_if_changed(arguments->output_file, output_buffer,
+                                      output_size);
+                free(output_buffer);
+        }
 
-                                cpc_byte = cpc_byte << 1;
+        printf("Finished writing file '%s'.\n", arguments->output_file);
 
-                                switch (arguments.crtc_mode)
-                                {
-                                case 0:
-                                        cpc_byte |=
-                                                (color_palette_index & 8) >> 3 |
-                                                (color_palette_index & 4) << 2 |
-                                                (color_palette_index & 2) << 1 |
-                                                (color_palette_index & 1) << 6;
-                                        break;
-                                case 1:
-                                        cpc_byte |=
-                                                (color_palette_index & 2) >> 1 |
-                                                (color_palette_index & 1) << 4;
-                                        break;
-                                case 2:
-                                        cpc_byte |= color_palette_index;
-                                        break;
-                                default:
-                                        fprintf(stderr,
-                                                "png2cpcsprite: internal "
-                                                "error: are we really supposed "
-                                                "to do mode %d?\n",
-                                                arguments.crtc_mode);
-                                        // Yes, we don't cleanup.  Quick and
-                                        // dirty!
-                                        exit(1);
-                                }
-                        }
-                        *w = cpc_byte;
-                        w++;
-                }
+        report_end_stage(&report, "write");
+
+        if (arguments->report_format)
+        {
+                char *report_file = arguments->report_file;
 
-                if (pixeldata != buffer + buffer_size)
+                if (report_file == NULL)
                 {
-                        fprintf(stderr,
-                                "png2cpcsprite: warning: did not consume "
-                                "exacly all %lu bytes of input buffer, "
-                                "actually %ld (%p != %p).\n",
-                                buffer_size, w - buffer, w,
-                                buffer + buffer_size);
+                        report_file = malloc(strlen(arguments->output_file) +
+                                             sizeof(".report.json"));
+                        sprintf(report_file, "%s.report.json",
+                                arguments->output_file);
                 }
 
-                if (w != sprite_buffer + sprite_bytes)
+                /* Mode and palette of an atlas are those of its
+                 * symbols, from the first sprite. */
+                struct arguments report_arguments = *arguments;
+
+                if (atlas != NULL)
                 {
-                        fprintf(stderr,
-                                "png2cpcsprite: warning: did not produce "
-                                "exacly the expected %u bytes of sprite data, "
-                                "actually %lu (%p != %p).\n",
-                                sprite_bytes, w - sprite_buffer, w,
-                                sprite_buffer + sprite_bytes);
+                        report_arguments.crtc_mode = atlas->crtc_mode;
+                        memcpy(report_arguments.explicit_palette,
+                               atlas->palette, sizeof(atlas->palette));
+                        report_arguments.explicit_palette_count =
+                                atlas->palette_count;
                 }
+
+                write_json_report(&report_arguments, &report, symbol_name,
+                                  report_file);
         }
+}
+
+#define MAX_WATCHED_FILES 1024
+
+/* What --watch remembers about each input file it converted. */
+typedef struct watched_file
+{
+        char *name;
+        u_int64_t content_hash;
+} watched_file;
+
+watched_file watched_files[MAX_WATCHED_FILES];
+int watched_file_count;
 
-        printf("\nGenerated %u bytes of sprite data, will write them "
-               "to output "
-               "file '%s'.\n",
-               sprite_bytes, arguments.output_file);
+/* FNV-1a over the file content, or 0 if it cannot be read. */
+u_int64_t hash_file_content(const char *file_name)
+{
+        FILE *f = fopen(file_name, "rb");
 
-        if (!arguments.name_stem)
+        if (f == NULL)
         {
-                printf("No name stem supplied on command line.\n");
+                return 0;
+        }
 
-                const char *last_part_of_input_file_name =
-                        strrchr(arguments.input_file, '/');
-                if (last_part_of_input_file_name == NULL)
-                {
-                        last_part_of_input_file_name = arguments.input_file;
-                }
-                else
+        u_int64_t hash = 0xcbf29ce484222325ULL;
+        int c;
+
+        while ((c = fgetc(f)) != EOF)
+        {
+                hash = (hash ^ (u_int8_t)c) * 0x100000001b3ULL;
+        }
+
+        fclose(f);
+
+        return hash;
+}
+
+watched_file *find_watched_file(const char *name)
+{
+        for (int i = 0; i < watched_file_count; i++)
+        {
+                if (strcmp(watched_files[i].name, name) == 0)
                 {
-                        last_part_of_input_file_name++;
+                        return &watched_files[i];
                 }
+        }
 
-                char *auto_name_stem = strdup(last_part_of_input_file_name);
-
-                /*
-                  From
-             cpc-dev-tool-chain/tool/sdcc/sdcc-3.9.0/sdas/doc/asmlnk.txt
+        if (watched_file_count == MAX_WATCHED_FILES)
+        {
+                return NULL;
+        }
 
-             1.  Symbols  can  be  composed  of alphanumeric characters,
-                 dollar signs ($),  periods  (.),  and  underscores  (_)
-                 only.
+        watched_file *w = &watched_files[watched_file_count++];
+        w->name = strdup(name);
+        w->content_hash = 0;
 
-             2.  The  first  character  of a symbol must not be a number
-                 (except in the case of reusable symbols).
+        return w;
+}
 
-                 */
+bool is_png_file_name(const char *name)
+{
+        size_t length = strlen(name);
 
-                char *auto_name_stem_end =
-                        auto_name_stem + strlen(auto_name_stem);
+        return length > 4 && strcmp(name + length - 4, ".png") == 0;
+}
 
-                const char *valid_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghij"
-                                          "klmnopqrstuvwxyz0123456789_";
+/* Convert directory/name if its content changed since last time.
+ * Conversion runs in a child process, so that the quick and dirty
+ * exit() on any error only ends that conversion, not the watch. */
+void watch_regenerate(struct arguments *arguments, const char *name,
+                      bool only_if_output_is_stale)
+{
+        const char *directory = arguments->watch_directory;
+        const char *output_suffix = arguments->assembler == ASSEMBLER_RASM
+                                            ? ".generated.asm"
+                                            : ".generated.s";
+
+        char input_file[PATH_MAX];
+        char output_file[PATH_MAX];
+        snprintf(input_file, sizeof(input_file), "%s/%s", directory, name);
+        snprintf(output_file, sizeof(output_file), "%s/%.*s%s", directory,
+                 (int)(strlen(name) - 4), name, output_suffix);
+
+        if (only_if_output_is_stale)
+        {
+                struct stat input_stat, output_stat;
 
+                if (stat(input_file, &input_stat) == 0 &&
+                    stat(output_file, &output_stat) == 0 &&
+                    output_stat.st_mtime >= input_stat.st_mtime)
                 {
-                        char *p = auto_name_stem;
-                        while (p != auto_name_stem_end)
+                        watched_file *w = find_watched_file(name);
+                        if (w != NULL)
                         {
-                                size_t advance = strspn(p, valid_chars);
-                                p += advance;
-                                if ((*p) != 0)
-                                {
-                                        *p = '_';
-                                }
+                                w->content_hash = hash_file_content(input_file);
                         }
+                        return;
                 }
+        }
 
-                arguments.name_stem = auto_name_stem;
+        watched_file *w = find_watched_file(name);
+        u_int64_t content_hash = hash_file_content(input_file);
+
+        if (w != NULL && content_hash != 0 && w->content_hash == content_hash)
+        {
+                printf("png2cpcsprite: '%s' content unchanged, skipped.\n",
+                       input_file);
+                return;
         }
 
-        printf("Will use symbol name '%s'\n", arguments.name_stem);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
 
-        FILE *output_file = fopen(arguments.output_file, "w");
+        fflush(stdout);
+        fflush(stderr);
 
-        if (output_file == NULL)
+        pid_t pid = fork();
+
+        if (pid == 0)
         {
-                fprintf(stderr,
-                        "png2cpcsprite: error: could not open output "
-                        "file "
-                        "'%s'.",
-                        arguments.output_file);
-                // Yes, we don't cleanup.  Quick and dirty!
-                exit(1);
+                struct arguments child_arguments = *arguments;
+                child_arguments.input_file = input_file;
+                child_arguments.output_file = output_file;
+                child_arguments.name_stem = NULL;
+                child_arguments.report_file = NULL;
+                child_arguments.watch_directory = NULL;
+                child_arguments.write_only_if_changed = true;
+
+                convert_and_write(&child_arguments);
+
+                exit(0);
         }
 
-#define MAX_STRINGS_SIZE 255
+        int status = 1;
 
-        char symbol_name[MAX_STRINGS_SIZE];
-        snprintf(symbol_name, MAX_STRINGS_SIZE, arguments.symbol_format_string,
-                 arguments.name_stem);
+        if (pid < 0 || waitpid(pid, &status, 0) < 0)
+        {
+                perror("png2cpcsprite: could not run conversion");
+                status = 1;
+        }
 
-        char module_name[MAX_STRINGS_SIZE];
-        snprintf(module_name, MAX_STRINGS_SIZE, arguments.module_format_string,
-                 arguments.name_stem);
+        clock_gettime(CLOCK_MONOTONIC, &end);
 
-        fprintf(output_file, ".module %s\n\n", module_name);
+        double milliseconds = (end.tv_sec - start.tv_sec) * 1e3 +
+                              (end.tv_nsec - start.tv_nsec) / 1e6;
 
-        char area_name[MAX_STRINGS_SIZE];
-        snprintf(area_name, MAX_STRINGS_SIZE, arguments.area_format_string,
-                 arguments.name_stem);
+        bool success = WIFEXITED(status) && WEXITSTATUS(status) == 0;
 
-        if (strlen(area_name))
+        printf("png2cpcsprite: %s '%s' -> '%s' in %.1f ms.\n",
+               success ? "converted" : "FAILED to convert", input_file,
+               output_file, milliseconds);
+        fflush(stdout);
+
+        if (w != NULL)
         {
-                fprintf(output_file, ".area %s\n\n", area_name);
+                /* After a failure, the next save is retried even if
+                 * identical. */
+                w->content_hash = success ? content_hash : 0;
         }
+}
+
+void watch_directory(struct arguments *arguments)
+{
+        const char *directory = arguments->watch_directory;
 
-        fprintf(output_file, "%s_bytes == 0x%04x\n", symbol_name, sprite_bytes);
-        fprintf(output_file, "%s_height == %d\n", symbol_name, image.height);
-        fprintf(output_file, "%s_pixels_per_line == %d\n", symbol_name,
-                width_pixels);
-        fprintf(output_file, "%s_bytes_per_line == %d\n", symbol_name,
-                width_bytes);
+        /* Shared, so that children fill it for their successors. */
+        rgb_to_ink_cache = mmap(NULL,
+                                RGB_TO_INK_CACHE_SIZE *
+                                        sizeof(rgb_to_ink_cache_entry),
+                                PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
 
-        if (arguments.explicit_palette_count > 0)
+        if (rgb_to_ink_cache == MAP_FAILED)
         {
-                fprintf(output_file, "\n%s_palette_count == %d\n", symbol_name,
-                        arguments.explicit_palette_count);
+                rgb_to_ink_cache = NULL;
+        }
 
-                for (int i = 0; i < arguments.explicit_palette_count; i++)
-                {
-                        fprintf(output_file, "%s_palette_ink_%d == %d\n",
-                                symbol_name, i, arguments.explicit_palette[i]);
-                }
-                printf("\n");
+        int inotify_fd = inotify_init();
+
+        if (inotify_fd < 0 ||
+            inotify_add_watch(inotify_fd, directory,
+                              IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+                fprintf(stderr, "png2cpcsprite: cannot watch '%s': %s\n",
+                        directory, strerror(errno));
+                exit(1);
         }
 
-        fprintf(output_file, "\n%s_data::\n", symbol_name);
+        DIR *dir = opendir(directory);
+
+        if (dir == NULL)
+        {
+                fprintf(stderr, "png2cpcsprite: cannot list '%s': %s\n",
+                        directory, strerror(errno));
+                exit(1);
+        }
+
+        struct dirent *dirent;
 
+        while ((dirent = readdir(dir)) != NULL)
         {
-                u_int8_t *b = sprite_buffer;
-                for (size_t yplain = 0; yplain < image.height; yplain++)
+                if (is_png_file_name(dirent->d_name))
                 {
-                        int y = arguments.bottom_to_top
-                                        ? image.height - 1 - yplain
-                                        : yplain;
-                        u_int8_t bytes_on_this_line = 0;
+                        watch_regenerate(arguments, dirent->d_name, true);
+                }
+        }
 
-                        b = &(sprite_buffer[width_bytes * y]);
+        closedir(dir);
 
-                        for (size_t x = 0; x < width_bytes; x++)
-                        {
-                                u_int8_t byte = *(b++);
+        printf("png2cpcsprite: watching '%s' for PNG files.\n", directory);
+        fflush(stdout);
 
-                                if (bytes_on_this_line >= 12)
-                                {
-                                        bytes_on_this_line = 0;
-                                }
+        char events[sizeof(struct inotify_event) + NAME_MAX + 1]
+                __attribute__((aligned(__alignof__(struct inotify_event))));
 
-                                if (bytes_on_this_line == 0)
-                                {
-                                        fprintf(output_file, "\n\t.byte ");
-                                }
-                                else
-                                {
-                                        fprintf(output_file, ", ");
-                                }
-                                bytes_on_this_line++;
+        for (;;)
+        {
+                ssize_t length = read(inotify_fd, events, sizeof(events));
 
-                                fprintf(output_file, "0x%02x", byte);
+                if (length < 0)
+                {
+                        if (errno == EINTR)
+                        {
+                                continue;
+                        }
+                        perror("png2cpcsprite: reading inotify events");
+                        exit(1);
+                }
+
+                for (char *p = events; p < events + length;)
+                {
+                        struct inotify_event *event =
+                                (struct inotify_event *)p;
+
+                        if (event->len > 0 && is_png_file_name(event->name))
+                        {
+                                watch_regenerate(arguments, event->name,
+                                                 false);
                         }
+
+                        p += sizeof(struct inotify_event) + event->len;
                 }
-                fprintf(output_file, "\n");
         }
+}
 
-        fprintf(output_file, "\n%s_data_end::\n", symbol_name);
+int main(int argc, const char **argv)
+{
+        struct arguments arguments;
+        memset(&arguments, 0, sizeof(arguments));
+        arguments.symbol_format_string = symbol_format_string_default;
+        arguments.module_format_string = module_format_string_default;
+        arguments.area_format_string = area_format_string_default;
 
-        fclose(output_file);
+        /* Parse our arguments; every option seen by parse_opt will
+           be reflected in arguments. */
+        argp_parse(&argp, argc, (char **restrict)argv, 0, 0, &arguments);
+
+        if (arguments.watch_directory != NULL)
+        {
+                watch_directory(&arguments);
+        }
 
-        printf("Finished writing file '%s'.\n", arguments.output_file);
+        convert_and_write(&arguments);
 
         printf("Success. Exiting.\n");
 
@@ -0,0 +1,66 @@
+/* Write the input image of the --plus_sprites test: 20x17 pixels with
+ * a 16-entry palette, so that it is cut into 2x2 sprites, the last
+ * column and line extended with pen 0.
+ *
+ * Pixel (x,y) has pen (x + 3 * y) % 16.  Palette entry i has red i,
+ * green 15 - i and blue 5 * i % 16 in 4-bit levels, each scaled by 17
+ * so that they round back exactly. */
+
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 20
+#define HEIGHT 17
+
+int main(int argc, char **argv)
+{
+        if (argc != 2)
+        {
+                fprintf(stderr, "usage: %s <output.png>\n", argv[0]);
+                return 1;
+        }
+
+        FILE *f = fopen(argv[1], "wb");
+        png_structp png =
+                png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+        png_infop info = png_create_info_struct(png);
+
+        if (f == NULL || png == NULL || info == NULL ||
+            setjmp(png_jmpbuf(png)))
+        {
+                fprintf(stderr, "could not write '%s'\n", argv[1]);
+                return 1;
+        }
+
+        png_init_io(png, f);
+        png_set_IHDR(png, info, WIDTH, HEIGHT, 8, PNG_COLOR_TYPE_PALETTE,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+
+        png_color palette[16];
+        for (int i = 0; i < 16; i++)
+        {
+                palette[i].red = i * 17;
+                palette[i].green = (15 - i) * 17;
+                palette[i].blue = (5 * i % 16) * 17;
+        }
+        png_set_PLTE(png, info, palette, 16);
+        png_write_info(png, info);
+
+        for (int y = 0; y < HEIGHT; y++)
+        {
+                png_byte row[WIDTH];
+                for (int x = 0; x < WIDTH; x++)
+                {
+                        row[x] = (x + 3 * y) % 16;
+                }
+                png_write_row(png, row);
+        }
+
+        png_write_end(png, info);
+        png_destroy_write_struct(&png, &info);
+        fclose(f);
+
+        return 0;
+}
@@ -0,0 +1,730 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <argp.h>
+#include <stdbool.h>
+
+const char *argp_program_version = "ym2cpcpsg 0.1";
+const char *argp_program_bug_address = "<stephane_cpcitor@gourichon.org>";
+
+#define symbol_format_string_default "_psg_%s"
+#define module_format_string_default "module_%s"
+#define area_format_string_default ""
+
+#define REGISTER_COUNT 14
+#define ENVELOPE_SHAPE 13
+#define CPC_PSG_CLOCK 1000000
+
+#define MASK_WAIT 0x4000
+#define MASK_END 0x8000
+
+static char doc[] =
+        "\n"
+        "ym2cpcpsg by Stéphane Gourichon (cpcitor).\n"
+        "\n"
+        "## Summary: what it does\n\n"
+        "Convert an AY/YM register dump (YM3, YM5 or YM6 file, or a raw "
+        "dump) into a delta-compressed register frame stream played by "
+        "cfwi_psg_player on an Amstrad CPC, expressed as assembly source "
+        "code.\n"
+        "\n"
+        "## Output\n\n"
+        "For each frame, the stream holds a 16-bit mask of the registers "
+        "that change followed by their new values, so that the player "
+        "only writes those.  Runs of frames without change take 2 bytes.  "
+        "The loop frame holds all registers, since it is reached from two "
+        "different previous frames.  See cfwi_psg_player.h for the exact "
+        "format.\n"
+        "\n"
+        "Register values are adjusted for the CPC: periods are scaled "
+        "from the master clock of the input to the 1 MHz of the CPC PSG, "
+        "unused bits (including YM6 special effects) are cleared, and "
+        "mixer bit 6 is cleared to keep PSG port A as input for the "
+        "keyboard.  Envelope shape (register 13) is written only in "
+        "frames where the input has a value other than 0xFF, as in YM "
+        "files, since writing it restarts the envelope.\n"
+        "\n"
+        "YM files are usually distributed compressed with LHA: extract "
+        "them first, for example with 'lha e' or '7z x'.\n"
+        "\n"
+        "Output symbols are <symbol>_data and <symbol>_data_end, "
+        "<symbol>_frames (number of frames) and <symbol>_registers "
+        "(registers used by the stream).";
+
+static struct argp_option options[] = {
+        {0, 0, 0, 0, "Input/output", 1},
+        {"input", 'i', "<input_filename.ym>", 0,
+         "Path to an input file, an uncompressed YM file (YM3!, YM3b, YM5! "
+         "or YM6!) or with --raw a raw register dump.",
+         1},
+        {"output", 'o', "<output_filename.s>", 0,
+         "Path where the output file will be written in assembly source "
+         "format.",
+         1},
+        {"binary", 'b', "<output_filename.bin>", 0,
+         "Optional.  "
+         "Also write the stream as a binary file, for example to be loaded "
+         "at run time.",
+         1},
+        {0, 0, 0, 0, "Processing", 2},
+        {"raw", 'r', "<14> or <16>", 0,
+         "Optional.  "
+         "Input is a raw dump of 14 or 16 bytes per frame, registers 0 to 13 "
+         "(or 15) of one frame after the other, instead of a YM file.  "
+         "Master clock is then taken from --clock.",
+         2},
+        {"clock", 'c', "<hertz>", 0,
+         "Optional.  "
+         "Master clock of the input, overriding the one in the YM file.  "
+         "Default is from the YM file, else 2000000 (Atari ST) for YM3 "
+         "files, else 1000000 (CPC).",
+         2},
+        {"loop", 'l', "<frame> or <none>", 0,
+         "Optional.  "
+         "Frame number where the stream loops after its last frame, or "
+         "'none' to stop playing.  Default is from the YM file, else "
+         "frame 0.  Use 'none' for sound effects.",
+         2},
+        {0, 0, 0, 0, "Assembly-level naming", 3},
+        {"module_format_string", 3, "<myprefix_%s_mysuffix> or <my_module_name>",
+         0,
+         "Optional.  "
+         "Format string to generate an assembly module name.  "
+         "Default is '" module_format_string_default "'.",
+         3},
+        {"area_format_string", 7, "<myprefix_%s_mysuffix> or <my_area_name>",
+         0,
+         "Optional.  "
+         "Format string to generate an assembly area name (.area AREANAME).  "
+         "If empty, no .area line is generated.  "
+         "Default is '" area_format_string_default "'.",
+         3},
+        {"name_stem", 'n', "somename", 0,
+         "Optional.  "
+         "String associated with the stream.  Default is to generate a name "
+         "from the file part in the 'input' argument up to its first dot, "
+         "replacing invalid characters with an underscore '_'.",
+         3},
+        {"symbol_format_string", 2, "<myprefix_%s_mysuffix>", 0,
+         "Optional.  "
+         "Format string to generate symbol names.  A '%s' is mandatory else "
+         "the generated assembly file will be invalid.  Default is '" symbol_format_string_default
+         "', which C code sees as psg_<name_stem>_data.",
+         3},
+        {0}};
+
+struct arguments
+{
+        char *input_file;
+        char *output_file;
+        char *binary_file;
+        unsigned int raw_frame_size;
+        unsigned long clock;
+        bool loop_given;
+        long loop_frame;
+        char *name_stem;
+        char *symbol_format_string;
+        char *module_format_string;
+        char *area_format_string;
+};
+
+/* Register dump, one frame after the other. */
+typedef struct
+{
+        uint8_t (*regs)[REGISTER_COUNT];
+        size_t frame_count;
+        unsigned long clock;
+        unsigned int frequency;
+        long loop_frame; /* -1 if none */
+        /* Raw dumps hold the envelope shape of every frame, YM files
+         * 0xFF where it is not written. */
+        bool envelope_shape_every_frame;
+} register_dump;
+
+typedef struct
+{
+        uint8_t *bytes;
+        size_t size;
+        size_t capacity;
+        uint16_t registers_used;
+} stream;
+
+static void fail(const char *message, const char *detail)
+{
+        fprintf(stderr, "ym2cpcpsg: %s%s%s\n", message, detail ? ": " : "",
+                detail ? detail : "");
+        exit(1);
+}
+
+/* Parse a single option. */
+static error_t parse_opt(int key, char *arg, struct argp_state *state)
+{
+        struct arguments *arguments = state->input;
+
+        char *reason = NULL;
+
+        switch (key)
+        {
+        case 'i':
+                arguments->input_file = arg;
+                break;
+        case 'o':
+                arguments->output_file = arg;
+                break;
+        case 'b':
+                arguments->binary_file = arg;
+                break;
+        case 'r':
+                arguments->raw_frame_size = atoi(arg);
+                if (arguments->raw_frame_size != 14 &&
+                    arguments->raw_frame_size != 16)
+                {
+                        reason = "raw frame size must be 14 or 16";
+                        goto invalid;
+                }
+                break;
+        case 'c':
+                arguments->clock = strtoul(arg, NULL, 10);
+                if (arguments->clock == 0)
+                {
+                        reason = "invalid clock";
+                        goto invalid;
+                }
+                break;
+        case 'l':
+                arguments->loop_given = true;
+                if (strcmp(arg, "none") == 0)
+                {
+                        arguments->loop_frame = -1;
+                }
+                else
+                {
+                        char *end;
+                        arguments->loop_frame = strtol(arg, &end, 10);
+                        if (*end != 0 || arguments->loop_frame < 0)
+                        {
+                                reason = "loop must be a frame number or "
+                                         "'none'";
+                                goto invalid;
+                        }
+                }
+                break;
+        case 'n':
+                arguments->name_stem = arg;
+                break;
+        case 2:
+                arguments->symbol_format_string = arg;
+                break;
+        case 3:
+                arguments->module_format_string = arg;
+                break;
+        case 7:
+                arguments->area_format_string = arg;
+                break;
+        case ARGP_KEY_ARG:
+                reason = "stray argument";
+                goto invalid;
+        case ARGP_KEY_END:
+                if (arguments->input_file == NULL)
+                {
+                        argp_error(state, "missing --input");
+                }
+                if (arguments->output_file == NULL &&
+                    arguments->binary_file == NULL)
+                {
+                        argp_error(state, "missing --output or --binary");
+                }
+                break;
+        default:
+                return ARGP_ERR_UNKNOWN;
+        }
+        return 0;
+
+invalid:
+        argp_error(state, "%s: %s", reason, arg);
+        return EINVAL;
+}
+
+static struct argp argp = {options, parse_opt, 0 /* args_doc */, doc, 0, 0, 0};
+
+static uint8_t *read_whole_file(const char *file_name, size_t *size)
+{
+        FILE *f = fopen(file_name, "rb");
+        if (f == NULL)
+        {
+                perror(file_name);
+                exit(1);
+        }
+
+        size_t capacity = 65536;
+        uint8_t *data = malloc(capacity);
+        *size = 0;
+        size_t got;
+        while ((got = fread(data + *size, 1, capacity - *size, f)) > 0)
+        {
+                *size += got;
+                if (*size == capacity)
+                {
+                        capacity *= 2;
+                        data = realloc(data, capacity);
+                }
+        }
+        fclose(f);
+        return data;
+}
+
+static uint32_t read_be(const uint8_t **p, const uint8_t *end, int bytes)
+{
+        if (*p + bytes > end)
+        {
+                fail("truncated YM header", NULL);
+        }
+        uint32_t value = 0;
+        while (bytes--)
+        {
+                value = (value << 8) | *((*p)++);
+        }
+        return value;
+}
+
+static void skip_bytes(const uint8_t **p, const uint8_t *end, uint32_t bytes)
+{
+        if ((size_t)(end - *p) < bytes)
+        {
+                fail("truncated YM header", NULL);
+        }
+        *p += bytes;
+}
+
+static void skip_string(const uint8_t **p, const uint8_t *end)
+{
+        while (*p < end && **p != 0)
+        {
+                (*p)++;
+        }
+        if (*p == end)
+        {
+                fail("truncated YM header", NULL);
+        }
+        (*p)++;
+}
+
+/* Copy frames of frame_size bytes, interleaved (all frames of
+ * register 0, then all frames of register 1...) or not. */
+static void copy_frames(register_dump *dump, const uint8_t *p,
+                        size_t frame_size, bool interleaved)
+{
+        dump->regs = calloc(dump->frame_count, REGISTER_COUNT);
+        for (size_t frame = 0; frame < dump->frame_count; frame++)
+        {
+                for (int r = 0; r < REGISTER_COUNT; r++)
+                {
+                        dump->regs[frame][r] =
+                                interleaved
+                                        ? p[r * dump->frame_count + frame]
+                                        : p[frame * frame_size + r];
+                }
+        }
+}
+
+static void read_ym(register_dump *dump, const uint8_t *data, size_t size)
+{
+        const uint8_t *p = data;
+        const uint8_t *end = data + size;
+
+        if (size >= 3 && memcmp(data, "-lh", 3) == 0)
+        {
+                fail("input looks LHA compressed, extract it first", NULL);
+        }
+        if (size < 4)
+        {
+                fail("input too short for a YM file", NULL);
+        }
+
+        dump->frequency = 50;
+
+        if (memcmp(data, "YM3!", 4) == 0 || memcmp(data, "YM3b", 4) == 0)
+        {
+                bool has_loop = data[3] == 'b';
+                size_t payload = size - 4 - (has_loop ? 4 : 0);
+                dump->frame_count = payload / REGISTER_COUNT;
+                dump->clock = 2000000;
+                dump->loop_frame = 0;
+                if (has_loop)
+                {
+                        const uint8_t *l = end - 4;
+                        /* YM3b loop frame is little-endian */
+                        dump->loop_frame = l[0] | (l[1] << 8) | (l[2] << 16) |
+                                           ((uint32_t)l[3] << 24);
+                }
+                copy_frames(dump, data + 4, REGISTER_COUNT, true);
+                return;
+        }
+
+        if (memcmp(data, "YM5!", 4) != 0 && memcmp(data, "YM6!", 4) != 0)
+        {
+                fail("not a YM3, YM5 or YM6 file (try --raw)", NULL);
+        }
+        p += 4;
+        if (end - p < 8 || memcmp(p, "LeOnArD!", 8) != 0)
+        {
+                fail("missing YM signature", NULL);
+        }
+        p += 8;
+
+        dump->frame_count = read_be(&p, end, 4);
+        uint32_t attributes = read_be(&p, end, 4);
+        unsigned int digidrum_count = read_be(&p, end, 2);
+        dump->clock = read_be(&p, end, 4);
+        dump->frequency = read_be(&p, end, 2);
+        dump->loop_frame = read_be(&p, end, 4);
+        skip_bytes(&p, end, read_be(&p, end, 2)); /* additional data */
+
+        while (digidrum_count--)
+        {
+                skip_bytes(&p, end, read_be(&p, end, 4));
+        }
+
+        skip_string(&p, end); /* song name */
+        skip_string(&p, end); /* author */
+        skip_string(&p, end); /* comment */
+
+        if ((size_t)(end - p) < dump->frame_count * 16)
+        {
+                fail("truncated YM register data", NULL);
+        }
+        copy_frames(dump, p, 16, attributes & 1);
+}
+
+static void read_raw(register_dump *dump, const uint8_t *data, size_t size,
+                     unsigned int frame_size)
+{
+        dump->frame_count = size / frame_size;
+        dump->clock = CPC_PSG_CLOCK;
+        dump->frequency = 50;
+        dump->loop_frame = 0;
+        dump->envelope_shape_every_frame = true;
+        copy_frames(dump, data, frame_size, false);
+}
+
+static unsigned long scale_period(unsigned long period, unsigned long clock,
+                                  unsigned long max)
+{
+        unsigned long scaled =
+                (period * CPC_PSG_CLOCK + clock / 2) / clock;
+        return scaled > max ? max : scaled;
+}
+
+/* Adjust one frame of registers for the CPC PSG. */
+static void adjust_frame(uint8_t *r, unsigned long clock)
+{
+        for (int channel = 0; channel < 3; channel++)
+        {
+                unsigned long period =
+                        r[channel * 2] | ((r[channel * 2 + 1] & 0x0f) << 8);
+                period = scale_period(period, clock, 0xfff);
+                r[channel * 2] = period & 0xff;
+                r[channel * 2 + 1] = period >> 8;
+        }
+
+        r[6] = scale_period(r[6] & 0x1f, clock, 0x1f);
+        r[7] &= 0x3f;
+        r[8] &= 0x1f;
+        r[9] &= 0x1f;
+        r[10] &= 0x1f;
+
+        {
+                unsigned long period = r[11] | (r[12] << 8);
+                period = scale_period(period, clock, 0xffff);
+                r[11] = period & 0xff;
+                r[12] = period >> 8;
+        }
+
+        if (r[ENVELOPE_SHAPE] != 0xff)
+        {
+                r[ENVELOPE_SHAPE] &= 0x0f;
+        }
+}
+
+static void emit(stream *s, uint8_t byte)
+{
+        if (s->size == s->capacity)
+        {
+                s->capacity = s->capacity ? s->capacity * 2 : 4096;
+                s->bytes = realloc(s->bytes, s->capacity);
+        }
+        s->bytes[s->size++] = byte;
+}
+
+static void emit_wait(stream *s, unsigned int *wait)
+{
+        while (*wait > 0)
+        {
+                unsigned int count = *wait > 255 ? 255 : *wait;
+                emit(s, count);
+                emit(s, MASK_WAIT >> 8);
+                *wait -= count;
+        }
+}
+
+static void encode(const register_dump *dump, stream *s)
+{
+        int previous[REGISTER_COUNT];
+        unsigned int wait = 0;
+        size_t loop_offset = 0xffff;
+
+        for (int r = 0; r < REGISTER_COUNT; r++)
+        {
+                previous[r] = -1;
+        }
+
+        /* header, loop offset is patched below */
+        emit(s, 0xff);
+        emit(s, 0xff);
+        emit(s, 0);
+        emit(s, 0);
+
+        for (size_t frame = 0; frame < dump->frame_count; frame++)
+        {
+                const uint8_t *r = dump->regs[frame];
+                bool loop_here = (long)frame == dump->loop_frame;
+                uint16_t mask = 0;
+
+                for (int i = 0; i < ENVELOPE_SHAPE; i++)
+                {
+                        if (loop_here || r[i] != previous[i])
+                        {
+                                mask |= 1 << i;
+                        }
+                }
+                /* Writing the envelope shape restarts the envelope, so
+                 * it is only written when the input asks for it: when
+                 * it is not 0xFF in YM files, when it changes in raw
+                 * dumps. */
+                bool write_shape = r[ENVELOPE_SHAPE] != 0xff;
+                if (dump->envelope_shape_every_frame)
+                {
+                        write_shape =
+                                loop_here ||
+                                r[ENVELOPE_SHAPE] != previous[ENVELOPE_SHAPE];
+                }
+                if (write_shape)
+                {
+                        mask |= 1 << ENVELOPE_SHAPE;
+                }
+
+                if (loop_here)
+                {
+                        emit_wait(s, &wait);
+                        loop_offset = s->size - 4;
+                }
+
+                if (mask == 0)
+                {
+                        wait++;
+                        continue;
+                }
+
+                emit_wait(s, &wait);
+                emit(s, mask & 0xff);
+                emit(s, mask >> 8);
+                for (int i = 0; i < REGISTER_COUNT; i++)
+                {
+                        if (mask & (1 << i))
+                        {
+                                emit(s, r[i]);
+                                previous[i] = r[i];
+                        }
+                }
+                s->registers_used |= mask;
+        }
+
+        emit_wait(s, &wait);
+        emit(s, 0);
+        emit(s, MASK_END >> 8);
+
+        if (s->size > 0xffff || (dump->loop_frame >= 0 && loop_offset > 0xfffe))
+        {
+                fail("stream too big", NULL);
+        }
+
+        s->bytes[0] = loop_offset & 0xff;
+        s->bytes[1] = loop_offset >> 8;
+        s->bytes[2] = s->registers_used & 0xff;
+        s->bytes[3] = s->registers_used >> 8;
+}
+
+/* Generate a valid assembler symbol part from the file part of a
+ * path, replacing invalid characters with an underscore. */
+static char *name_stem_from_file_name(const char *file_name)
+{
+        const char *last_part = strrchr(file_name, '/');
+        last_part = last_part == NULL ? file_name : last_part + 1;
+
+        char *stem = strdup(last_part);
+        char *dot = strchr(stem, '.');
+        if (dot != NULL && dot != stem)
+        {
+                *dot = 0;
+        }
+
+        const char *valid_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghij"
+                                  "klmnopqrstuvwxyz0123456789_";
+
+        for (char *p = stem; *p != 0; p++)
+        {
+                if (strchr(valid_chars, *p) == NULL)
+                {
+                        *p = '_';
+                }
+        }
+
+        return stem;
+}
+
+static void write_sdasz80_output(const struct arguments *arguments,
+                                 const register_dump *dump, const stream *s)
+{
+        const char *name_stem = arguments->name_stem
+                                        ? arguments->name_stem
+                                        : name_stem_from_file_name(
+                                                  arguments->input_file);
+
+        char symbol_name[256];
+        char module_name[256];
+        char area_name[256];
+        snprintf(symbol_name, sizeof(symbol_name),
+                 arguments->symbol_format_string, name_stem);
+        snprintf(module_name, sizeof(module_name),
+                 arguments->module_format_string, name_stem);
+        snprintf(area_name, sizeof(area_name), arguments->area_format_string,
+                 name_stem);
+
+        FILE *output_file = fopen(arguments->output_file, "w");
+        if (output_file == NULL)
+        {
+                perror(arguments->output_file);
+                exit(1);
+        }
+
+        fprintf(output_file, ".module %s\n\n", module_name);
+
+        if (strlen(area_name))
+        {
+                fprintf(output_file, ".area %s\n\n", area_name);
+        }
+
+        fprintf(output_file, "%s_frames == %zu\n", symbol_name,
+                dump->frame_count);
+        fprintf(output_file, "%s_registers == 0x%04x\n", symbol_name,
+                s->registers_used);
+
+        fprintf(output_file, "\n%s_data::\n", symbol_name);
+
+        for (size_t i = 0; i < s->size; i++)
+        {
+                fprintf(output_file, "%s0x%02x",
+                        i % 12 == 0 ? "\n\t.byte " : ", ", s->bytes[i]);
+        }
+        fprintf(output_file, "\n");
+
+        fprintf(output_file, "\n%s_data_end::\n", symbol_name);
+
+        fclose(output_file);
+}
+
+static void write_binary_output(const char *file_name, const stream *s)
+{
+        FILE *f = fopen(file_name, "wb");
+        if (f == NULL || fwrite(s->bytes, 1, s->size, f) != s->size)
+        {
+                perror(file_name);
+                exit(1);
+        }
+        fclose(f);
+}
+
+int main(int argc, const char **argv)
+{
+        struct arguments arguments;
+        memset(&arguments, 0, sizeof(arguments));
+        arguments.symbol_format_string = symbol_format_string_default;
+        arguments.module_format_string = module_format_string_default;
+        arguments.area_format_string = area_format_string_default;
+
+        /* Parse our arguments; every option seen by parse_opt will
+           be reflected in arguments. */
+        argp_parse(&argp, argc, (char **restrict)argv, 0, 0, &arguments);
+
+        size_t size;
+        uint8_t *data = read_whole_file(arguments.input_file, &size);
+
+        register_dump dump;
+        memset(&dump, 0, sizeof(dump));
+
+        if (arguments.raw_frame_size)
+        {
+                read_raw(&dump, data, size, arguments.raw_frame_size);
+        }
+        else
+        {
+                read_ym(&dump, data, size);
+        }
+
+        if (dump.frame_count == 0)
+        {
+                fail("no frame in input", arguments.input_file);
+        }
+        if (arguments.clock)
+        {
+                dump.clock = arguments.clock;
+        }
+        if (arguments.loop_given)
+        {
+                dump.loop_frame = arguments.loop_frame;
+        }
+        if (dump.loop_frame >= (long)dump.frame_count)
+        {
+                fprintf(stderr,
+                        "ym2cpcpsg: loop frame %ld past last frame, not "
+                        "looping.\n",
+                        dump.loop_frame);
+                dump.loop_frame = -1;
+        }
+        if (dump.frequency != 50)
+        {
+                fprintf(stderr,
+                        "ym2cpcpsg: warning: input is for %u Hz, the player "
+                        "plays one frame each 1/50 s.\n",
+                        dump.frequency);
+        }
+
+        for (size_t frame = 0; frame < dump.frame_count; frame++)
+        {
+                adjust_frame(dump.regs[frame], dump.clock);
+        }
+
+        stream s;
+        memset(&s, 0, sizeof(s));
+        encode(&dump, &s);
+
+        if (arguments.output_file)
+        {
+                write_sdasz80_output(&arguments, &dump, &s);
+        }
+        if (arguments.binary_file)
+        {
+                write_binary_output(arguments.binary_file, &s);
+        }
+
+        printf("%zu frames, %zu bytes (%.2f bytes per frame), loop at frame "
+               "%ld. Success. Exiting.\n",
+               dump.frame_count, s.size, (double)s.size / dump.frame_count,
+               dump.loop_frame);
+
+        free(data);
+        exit(0);
+}